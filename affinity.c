@@ -0,0 +1,259 @@
+/*
+ * File:   affinity.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the stage placement described in affinity.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include "affinity.h"
+
+#define AFFINITY_VAR "pipeaffinity"
+#define POLICY_CACHE "cache"
+#define POLICY_NODE  "node"
+
+#define CPU_DIR  "/sys/devices/system/cpu"
+#define NODE_DIR "/sys/devices/system/node"
+
+#define PATH_SIZE (128)
+#define LIST_SIZE (1024)
+
+// Adds the CPUs in list (e.g., "0,2,4-7") to set. Returns false if list isn't
+// a CPU list.
+static bool parseCpuList(const char* list, cpu_set_t* set)
+{
+    const char* p = list;
+    while(*p && !isspace((unsigned char)*p))
+    {
+        char* end;
+        long lo = strtol(p, &end, 10), hi = lo;
+        if(end == p || lo < 0)
+        {
+            return false;
+        }
+        if(*end == '-')
+        {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+            if(end == p || hi < lo)
+            {
+                return false;
+            }
+        }
+        for(long cpu = lo; cpu <= hi && cpu < CPU_SETSIZE; cpu++)
+        {
+            CPU_SET(cpu, set);
+        }
+        p = (*end == ',') ? end + 1 : end;
+        if(p == end && *p && !isspace((unsigned char)*p))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Sets set to the CPUs listed in the file path. Returns false if it can't be
+// read.
+static bool readCpuList(const char* path, cpu_set_t* set)
+{
+    char list[LIST_SIZE];
+    FILE* fp = fopen(path, "r");
+    bool ok = fp && fgets(list, sizeof(list), fp);
+    if(fp)
+    {
+        fclose(fp);
+    }
+    CPU_ZERO(set);
+    return ok && parseCpuList(list, set);
+}
+
+// Sets set to the CPUs sharing the last-level cache of cpu. Returns false if
+// the caches aren't known.
+static bool cacheCpus(int cpu, cpu_set_t* set)
+{
+    int bestLevel = 0;
+    for(int i = 0; ; i++)
+    {
+        char path[PATH_SIZE];
+        int level;
+        snprintf(path, sizeof(path), CPU_DIR "/cpu%d/cache/index%d/level", cpu,
+                 i);
+        FILE* fp = fopen(path, "r");
+        if(!fp)
+        {
+            break;
+        }
+        bool ok = fscanf(fp, "%d", &level) == 1;
+        fclose(fp);
+
+        snprintf(path, sizeof(path),
+                 CPU_DIR "/cpu%d/cache/index%d/shared_cpu_list", cpu, i);
+        cpu_set_t shared;
+        if(ok && level > bestLevel && readCpuList(path, &shared))
+        {
+            bestLevel = level;
+            *set = shared;
+        }
+    }
+    return bestLevel > 0;
+}
+
+// Sets set to the CPUs of cpu's NUMA node. Returns false if the node isn't
+// known.
+static bool nodeCpus(int cpu, cpu_set_t* set)
+{
+    char path[PATH_SIZE];
+    snprintf(path, sizeof(path), CPU_DIR "/cpu%d", cpu);
+    DIR* dir = opendir(path);
+    struct dirent* entry;
+    int node = -1;
+    while(dir && (entry = readdir(dir)) && node < 0)
+    {
+        if(strncmp(entry->d_name, "node", 4) == 0 &&
+           isdigit((unsigned char)entry->d_name[4]))
+        {
+            node = atoi(entry->d_name + 4);
+        }
+    }
+    if(dir)
+    {
+        closedir(dir);
+    }
+    if(node < 0)
+    {
+        return false;
+    }
+
+    snprintf(path, sizeof(path), NODE_DIR "/node%d/cpulist", node);
+    return readCpuList(path, set);
+}
+
+// Fills in masks, pinning the nStages stages one each to the CPUs of cpus in
+// turn
+static void pinInTurn(int nStages, const cpu_set_t* cpus, cpu_set_t* masks)
+{
+    int cpu = -1;
+    for(int i = 0; i < nStages; i++)
+    {
+        // the next CPU in the set, wrapping around
+        do
+        {
+            cpu = (cpu + 1) % CPU_SETSIZE;
+        }
+        while(!CPU_ISSET(cpu, cpus));
+
+        CPU_ZERO(&masks[i]);
+        CPU_SET(cpu, &masks[i]);
+    }
+}
+
+bool placeStages(int nStages, cpu_set_t* masks)
+{
+    const char* policy = getenv(AFFINITY_VAR);
+    if(!policy || !*policy)
+    {
+        return false;
+    }
+
+    cpu_set_t allowed, cpus;
+    int here = sched_getcpu();
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) < 0 || here < 0)
+    {
+        return false;
+    }
+
+    bool known;
+    if(strcmp(policy, POLICY_CACHE) == 0)
+    {
+        known = cacheCpus(here, &cpus);
+    }
+    else if(strcmp(policy, POLICY_NODE) == 0)
+    {
+        known = nodeCpus(here, &cpus);
+    }
+    else
+    {
+        CPU_ZERO(&cpus);
+        known = parseCpuList(policy, &cpus);
+        if(!known)
+        {
+            fprintf(stderr, "%s: Invalid CPU list\n", AFFINITY_VAR);
+        }
+    }
+
+    CPU_AND(&cpus, &cpus, &allowed);
+    if(!known || CPU_COUNT(&cpus) == 0)
+    {
+        return false;
+    }
+
+    if(strcmp(policy, POLICY_NODE) == 0)
+    {
+        for(int i = 0; i < nStages; i++)
+        {
+            masks[i] = cpus;
+        }
+    }
+    else
+    {
+        pinInTurn(nStages, &cpus, masks);
+    }
+    return true;
+}
+
+// Prints set to fp as a CPU list
+static void printCpuList(FILE* fp, const cpu_set_t* set)
+{
+    const char* sep = "";
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if(!CPU_ISSET(cpu, set))
+        {
+            continue;
+        }
+        int last = cpu;
+        while(last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set))
+        {
+            last++;
+        }
+        if(last > cpu)
+        {
+            fprintf(fp, "%s%d-%d", sep, cpu, last);
+        }
+        else
+        {
+            fprintf(fp, "%s%d", sep, cpu);
+        }
+        sep = ",";
+        cpu = last;
+    }
+}
+
+void reportPlacement(CMD* pipeRoot, const cpu_set_t* masks)
+{
+    fprintf(stderr, "placement (%s):", getenv(AFFINITY_VAR));
+
+    int i = 0;
+    CMD* cmd = pipeRoot;
+    for( ; ; cmd = cmd->right, i++)
+    {
+        CMD* stage = ISPIPE(cmd->type) ? cmd->left : cmd;
+        fprintf(stderr, "%s %s on CPU%s ", (i > 0) ? "," : "",
+                (stage->type == SIMPLE) ? stage->argv[0] : "(...)",
+                (CPU_COUNT(&masks[i]) > 1) ? "s" : "");
+        printCpuList(stderr, &masks[i]);
+        if(!ISPIPE(cmd->type))
+        {
+            break;
+        }
+    }
+    fprintf(stderr, "\n");
+}
@@ -0,0 +1,36 @@
+/*
+ * File:   affinity.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for placing the stages of a pipeline on CPUs, so that the data
+ * going through their pipes stays in a shared cache, or at least on one NUMA
+ * node, instead of crossing between sockets. $pipeaffinity picks the policy:
+ *
+ *   cache    pin the stages, in order, one each to the CPUs sharing the
+ *            last-level cache of the CPU the shell is on
+ *   node     confine every stage to the CPUs of the shell's NUMA node
+ *   a list   (e.g., 0,2,4-7) pin the stages, in order, one each to its CPUs
+ *
+ * Stages wrap around to the first CPU if there are more of them than CPUs.
+ * Only CPUs the shell may run on are used.
+ */
+
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <stdbool.h>
+#include <sched.h>
+#include "parse.h"
+
+// Fills in masks, one for each of the nStages stages of a pipeline, with the
+// CPUs each should run on. Returns false, leaving the stages to the
+// scheduler, if $pipeaffinity isn't set or names no usable CPUs.
+bool placeStages(int nStages, cpu_set_t* masks);
+
+// Prints the placement masks of the stages of the pipeline rooted at pipeRoot
+// to stderr
+void reportPlacement(CMD* pipeRoot, const cpu_set_t* masks);
+
+#endif
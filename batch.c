@@ -0,0 +1,472 @@
+/*
+ * File:   batch.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the batch built-in described in batch.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include "batch.h"
+#include "process.h"
+#include "fullIO.h"
+
+#define MEM_SUBSYSTEM MEM_BUILTIN
+#include "memStats.h"
+
+#define USAGE "batch: Usage: batch [-j jobs] [-k] [-n count] command " \
+              "[arg ...] [-- word ...]\n"
+
+// the bytes of argument space left unused, as xargs does, for whatever the
+// kernel or the command's loader may add
+#define HEADROOM (2048)
+
+#define INPUT_INIT_SIZE (64 * 1024)
+#define WORDS_INIT_SIZE (1024)
+#define RUNS_INIT_SIZE (8)
+#define GROWTH_FACTOR (2)
+
+#define COPY_SIZE (64 * 1024)
+
+extern char** environ;
+
+// a batch that has been started
+typedef struct
+{
+    int index;     // its place among the batches
+    pid_t pid;     // its process, or -1 if it couldn't be started
+    int pidfd;     // a descriptor to poll for its exit, or -1
+    int out;       // where its output is held with -k, or -1
+    bool done;     // has it been reaped?
+    int status;    //   and if so, its wait status
+} batchRun;
+
+// Reads all of fd into a malloc'd, null-terminated buffer. Returns it, or NULL
+// with errno set.
+static char* readInput(int fd)
+{
+    size_t size = INPUT_INIT_SIZE, len = 0;
+    char* buf = malloc(size);
+    for( ; ; )
+    {
+        if(len + 1 == size)
+        {
+            size *= GROWTH_FACTOR;
+            buf = realloc(buf, size);
+        }
+
+        ssize_t got = read(fd, buf + len, size - len - 1);
+        if(got == 0)
+        {
+            break;
+        }
+        else if(got < 0 && errno != EINTR)
+        {
+            int error = errno;
+            free(buf);
+            errno = error;
+            return NULL;
+        }
+        len += (got > 0) ? got : 0;
+    }
+    buf[len] = '\0';
+    return buf;
+}
+
+// Splits text in place into the words separated by white space, setting
+// *nWords to their number. Returns a malloc'd array of them.
+static char** splitWords(char* text, int* nWords)
+{
+    int size = WORDS_INIT_SIZE, n = 0;
+    char** words = malloc(sizeof(char*) * size);
+    for(char* c = text; *c; )
+    {
+        c += strspn(c, " \t\n");
+        if(!*c)
+        {
+            break;
+        }
+
+        if(n == size)
+        {
+            size *= GROWTH_FACTOR;
+            words = realloc(words, sizeof(char*) * size);
+        }
+        words[n++] = c;
+        c += strcspn(c, " \t\n");
+        if(*c)
+        {
+            *c++ = '\0';
+        }
+    }
+    *nWords = n;
+    return words;
+}
+
+// Returns the bytes of argument space taken by the n strings at strs
+static long argSpace(char** strs, int n)
+{
+    long space = 0;
+    for(int i = 0; i < n; i++)
+    {
+        space += strlen(strs[i]) + 1 + sizeof(char*);
+    }
+    return space;
+}
+
+// Returns the bytes of argument space left for the words of a batch, once the
+// environment, the command's own args fixed, and the terminating pointers
+// are accounted for
+static long wordSpace(char** fixed, int nFixed)
+{
+    int nEnv = 0;
+    for(char** var = environ; *var; var++, nEnv++);
+
+    long argMax = sysconf(_SC_ARG_MAX);
+    if(argMax <= 0)
+    {
+        argMax = _POSIX_ARG_MAX;
+    }
+    return argMax - HEADROOM - argSpace(environ, nEnv) -
+           argSpace(fixed, nFixed) - 2 * sizeof(char*);
+}
+
+// Copies everything from the file in, from its start, to out. Returns 0, or
+// -1 with errno set.
+static int copyOut(int in, int out)
+{
+    if(lseek(in, 0, SEEK_SET) < 0)
+    {
+        return -1;
+    }
+
+    bool viaSendfile = true;
+    char buf[COPY_SIZE];
+    for( ; ; )
+    {
+        ssize_t n;
+        if(viaSendfile)
+        {
+            n = sendfile(out, in, NULL, COPY_SIZE);
+            if(n < 0 && errno == EINVAL)
+            {
+                viaSendfile = false;
+                continue;
+            }
+        }
+        else if((n = read(in, buf, sizeof(buf))) > 0 &&
+                !writeAll(out, buf, n))
+        {
+            return -1;
+        }
+
+        if(n == 0)
+        {
+            return 0;
+        }
+        else if(n < 0 && errno != EINTR)
+        {
+            return -1;
+        }
+    }
+}
+
+// Starts run, the batch of the command cmd with the args argv, taking its
+// input from in and writing its output to out, or to a file of its own if
+// hold is true
+static void startRun(batchRun* run, CMD* cmd, char** argv, int argc, int in,
+                     int out, bool hold)
+{
+    CMD batchCmd = *cmd;
+    batchCmd.argc = argc;
+    batchCmd.argv = argv;
+    batchCmd.fromType = batchCmd.toType = NONE;
+    batchCmd.fromFile = batchCmd.toFile = NULL;
+    batchCmd.subst = NULL;
+    batchCmd.expand = false;
+
+    run->out = hold ? memfd_create("batch", MFD_CLOEXEC) : -1;
+    run->pid = spawnSimple(&batchCmd, in, (run->out >= 0) ? run->out : out,
+                           STDERR_FILENO);
+    run->pidfd = -1;
+    run->done = run->pid < 0;
+    run->status = W_EXITCODE(EXIT_FAILURE, 0);
+#ifdef SYS_pidfd_open
+    if(run->pid > 0)
+    {
+        run->pidfd = syscall(SYS_pidfd_open, run->pid, 0);
+    }
+#endif
+}
+
+// Reaps the finished run
+static void reapRun(batchRun* run)
+{
+    while(waitpid(run->pid, &run->status, 0) < 0 && errno == EINTR);
+    if(run->pidfd >= 0)
+    {
+        close(run->pidfd);
+    }
+    run->done = true;
+}
+
+// Waits until at least one of the n runs, of which at least one is still
+// running, has finished, and reaps those that have. Returns the number reaped.
+static int waitRuns(batchRun* runs, int n)
+{
+    struct pollfd fds[n];
+    int polled[n];
+    int nPolled = 0;
+    for(int i = 0; i < n; i++)
+    {
+        if(!runs[i].done && runs[i].pidfd < 0)
+        {
+            // without a pidfd, wait for the oldest
+            reapRun(&runs[i]);
+            return 1;
+        }
+        else if(!runs[i].done)
+        {
+            fds[nPolled].fd = runs[i].pidfd;
+            fds[nPolled].events = POLLIN;
+            polled[nPolled++] = i;
+        }
+    }
+
+    int ready;
+    while((ready = poll(fds, nPolled, -1)) < 0 && errno == EINTR);
+    if(ready < 0)
+    {
+        reapRun(&runs[polled[0]]);
+        return 1;
+    }
+
+    int reaped = 0;
+    for(int i = 0; i < nPolled; i++)
+    {
+        if(fds[i].revents)
+        {
+            reapRun(&runs[polled[i]]);
+            reaped++;
+        }
+    }
+    return reaped;
+}
+
+// Retires the run, once finished: writes out its held output, if any, and
+// records its status in *failed (the index of the first batch that failed)
+// and *status
+static void retireRun(batchRun* run, int out, int* failed, int* status)
+{
+    if(run->out >= 0)
+    {
+        if(copyOut(run->out, out) < 0)
+        {
+            perror("batch");
+        }
+        close(run->out);
+    }
+    if(GET_STATUS(run->status) != 0 && (*failed < 0 || run->index < *failed))
+    {
+        *failed = run->index;
+        *status = GET_STATUS(run->status);
+    }
+}
+
+// the options of a batch command
+typedef struct
+{
+    int jobs;      // the most batches run at once
+    bool keep;     // keep their output in order?
+    int count;     // the most words in a batch, or 0 for no limit
+} batchOptions;
+
+// Runs the command with the nFixed args fixed on the nWords words, in as few
+// batches as fit and opts allow, taking input from in and writing output to
+// out. Returns the exit status.
+static int runBatches(CMD* cmd, char** fixed, int nFixed, char** words,
+                      int nWords, int in, int out, const batchOptions* opts)
+{
+    long space = wordSpace(fixed, nFixed);
+    if(space <= 0)
+    {
+        fprintf(stderr, "batch: Environment too large\n");
+        return 1;
+    }
+
+    char** argv = malloc(sizeof(char*) * (nFixed + nWords + 1));
+    memcpy(argv, fixed, sizeof(char*) * nFixed);
+
+    // the batches started but not yet retired, in order
+    int runsSize = RUNS_INIT_SIZE, nRuns = 0, nRunning = 0;
+    batchRun* runs = malloc(sizeof(batchRun) * runsSize);
+    int failed = -1, status = 0;
+
+    signal(SIGINT, SIG_IGN);
+    for(int next = 0, index = 0; next < nWords || nRuns > 0; )
+    {
+        // start as many batches as may run
+        while(next < nWords && nRunning < opts->jobs)
+        {
+            int argc = nFixed;
+            for(long left = space; next < nWords; next++)
+            {
+                if(opts->count > 0 && argc - nFixed == opts->count)
+                {
+                    break;
+                }
+
+                long cost = strlen(words[next]) + 1 + sizeof(char*);
+                if(cost > left && argc > nFixed)
+                {
+                    break;
+                }
+                argv[argc++] = words[next];
+                left -= cost;
+            }
+            argv[argc] = NULL;
+
+            if(nRuns == runsSize)
+            {
+                runsSize *= GROWTH_FACTOR;
+                runs = realloc(runs, sizeof(batchRun) * runsSize);
+            }
+            runs[nRuns].index = index++;
+            startRun(&runs[nRuns], cmd, argv, argc, in, out,
+                     opts->keep && opts->jobs > 1);
+            nRunning += !runs[nRuns].done;
+            nRuns++;
+        }
+
+        // a batch frees its place once it finishes, even if its output is
+        // held behind that of a slower batch before it
+        if(nRunning > 0)
+        {
+            nRunning -= waitRuns(runs, nRuns);
+        }
+
+        // retire the finished batches, in order if keep is true
+        int kept = 0;
+        for(int i = 0; i < nRuns; i++)
+        {
+            if(runs[i].done && (!opts->keep || kept == 0))
+            {
+                retireRun(&runs[i], out, &failed, &status);
+            }
+            else
+            {
+                runs[kept++] = runs[i];
+            }
+        }
+        nRuns = kept;
+    }
+    signal(SIGINT, SIG_DFL);
+
+    free(runs);
+    free(argv);
+    return status;
+}
+
+int batch(CMD* cmd, int out)
+{
+    batchOptions opts = { 1, false, 0 };
+
+    int i = 1;
+    for( ; cmd->argv[i] && cmd->argv[i][0] == '-'; i++)
+    {
+        char* end;
+        if(strcmp(cmd->argv[i], "-k") == 0)
+        {
+            opts.keep = true;
+        }
+        else if(strcmp(cmd->argv[i], "-j") == 0 && cmd->argv[i + 1] &&
+                (opts.jobs = strtol(cmd->argv[i + 1], &end, 10)) > 0 && !*end)
+        {
+            i++;
+        }
+        else if(strcmp(cmd->argv[i], "-n") == 0 && cmd->argv[i + 1] &&
+                (opts.count = strtol(cmd->argv[i + 1], &end, 10)) > 0 &&
+                !*end)
+        {
+            i++;
+        }
+        else
+        {
+            fprintf(stderr, USAGE);
+            return 1;
+        }
+    }
+    if(!cmd->argv[i] || strcmp(cmd->argv[i], "--") == 0)
+    {
+        fprintf(stderr, USAGE);
+        return 1;
+    }
+
+    char** fixed = cmd->argv + i;
+    int nFixed = 0;
+    while(fixed[nFixed] && strcmp(fixed[nFixed], "--") != 0)
+    {
+        nFixed++;
+    }
+    if(fixed[nFixed])
+    {
+        // the words are given
+        return runBatches(cmd, fixed, nFixed, fixed + nFixed + 1,
+                          cmd->argc - i - nFixed - 1, STDIN_FILENO, out,
+                          &opts);
+    }
+
+    // the words are read, from a here document, a file, or standard input
+    char* text = NULL;
+    if(cmd->fromType == RED_HERE)
+    {
+        text = strdup(cmd->fromFile);
+    }
+    else
+    {
+        int fd = (cmd->fromType == RED_IN) ?
+                 open(cmd->fromFile, O_RDONLY | O_CLOEXEC) : STDIN_FILENO;
+        if(fd < 0 || !(text = readInput(fd)))
+        {
+            perror("batch");
+        }
+        if(fd >= 0 && fd != STDIN_FILENO)
+        {
+            close(fd);
+        }
+    }
+    int devNull = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    if(!text || devNull < 0)
+    {
+        free(text);
+        if(devNull >= 0)
+        {
+            close(devNull);
+        }
+        return 1;
+    }
+
+    int nWords;
+    char** words = splitWords(text, &nWords);
+    int status = runBatches(cmd, fixed, nFixed, words, nWords, devNull, out,
+                            &opts);
+    close(devNull);
+    free(words);
+    free(text);
+    return status;
+}
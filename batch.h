@@ -0,0 +1,32 @@
+/*
+ * File:   batch.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for the batch built-in, which, like xargs, runs a command on a
+ * list of words too long for one exec, in as few execs as possible:
+ *
+ *   batch [-j jobs] [-k] [-n count] command [arg ...] [-- word ...]
+ *
+ * The words are those after --, or else those read from standard input,
+ * which are separated by white space. They are packed, in order, into the
+ * largest batches whose arguments and environment fit in ARG_MAX, and
+ * command is run with its args and each batch in turn; with no words it isn't
+ * run at all. -n puts at most count words in a batch. -j runs up to jobs
+ * batches at once, launched as the shell launches any command (by the zygote,
+ * if it's running), and -k keeps the output of parallel batches in order,
+ * holding each batch's standard output until those before it have finished.
+ * Batches run on words from standard input get /dev/null as theirs.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "parse.h"
+
+// Executes the batch command cmd, writing the batches' output to out, and
+// returns its exit status: that of the first batch that failed, or 0
+int batch(CMD* cmd, int out);
+
+#endif
@@ -1,14 +1,26 @@
 /* 
  * File:   builtinCommands.c
  * Author: Alexander Schurman (alexander.schurman@gmail.com)
+ * Modified by: agent (agent@local)
  *
  * Created on November 20, 2012
  * 
- * Implementation of the built-in commands (cd, pushd, popd)
+ * Implementation of the built-in commands (cd, pushd, popd, memstats, setenv,
+ * unsetenv, echo, fdcache, batch, cache, history)
  */
 
 #include "builtinCommands.h"
 #include "stack.h"
+#include "fdCache.h"
+#include "batch.h"
+#include "outputCache.h"
+#include "history.h"
+#include "fullIO.h"
+#include <pthread.h>
+#include <time.h>
+
+#define MEM_SUBSYSTEM MEM_BUILTIN
+#include "memStats.h"
 
 // Executes the cd command with the given args. Returns the exit status.
 int cd(CMD* cmd)
@@ -35,21 +47,30 @@ int cd(CMD* cmd)
 // global directory stack to be used by pushd() and popd()
 stack* dirStack = NULL;
 
-// frees dirStack if it has been malloc-d
+// the shell's own directory stack, which dirStack points to unless
+// setDirStack() says otherwise
+stack* shellDirStack = NULL;
+
+// frees shellDirStack if it has been malloc-d
 void freeDirStack()
 {
-    if(dirStack)
+    if(shellDirStack)
     {
-        freeStack(dirStack);
+        freeStack(shellDirStack);
     }
 }
 
+void setDirStack(stack* stk)
+{
+    dirStack = stk ? stk : shellDirStack;
+}
+
 // Executes the pushd command with the given args. Returns the exit status.
 int pushd(CMD* cmd)
 {
     if(!dirStack)
     {
-        dirStack = mallocStack();
+        dirStack = shellDirStack = mallocStack();
         atexit(freeDirStack);
     }
     
@@ -91,7 +112,7 @@ int popd(CMD* cmd)
 {
     if(!dirStack)
     {
-        dirStack = mallocStack();
+        dirStack = shellDirStack = mallocStack();
         atexit(freeDirStack);
     }
     
@@ -120,42 +141,300 @@ int popd(CMD* cmd)
     }
 }
 
-int execBuiltin(CMD* cmd)
+// Executes the memstats command with the given args, printing the allocation
+// counters to out. With -r, the cumulative counters are reset after printing.
+// Returns the exit status.
+int memstats(CMD* cmd, int out)
 {
-    // file descriptors for stderr used for redirect
-    int newStderr = -1, oldStderr = -1;
-    
-    // redirect stderr if necessary
-    if(ISERROR(cmd->toType))
+    if(cmd->argc > 2 || (cmd->argc == 2 && strcmp(cmd->argv[1], "-r") != 0))
+    {
+        fprintf(stderr, "memstats: Usage: memstats [-r]\n");
+        return 1;
+    }
+
+    int status = dumpMemStats(out);
+    if(status == 0 && cmd->argc == 2)
+    {
+        resetMemStats();
+    }
+    return status;
+}
+
+extern char** environ;
+
+// Executes the setenv command with the given args, which prints the
+// environment to out with no args and sets a variable (to "" if no value is
+// given) otherwise. Returns the exit status.
+int setenvBuiltin(CMD* cmd, int out)
+{
+    if(cmd->argc > 3)
+    {
+        fprintf(stderr, "setenv: Too many arguments\n");
+        return 1;
+    }
+    else if(cmd->argc == 1)
+    {
+        for(char** var = environ; *var; var++)
+        {
+            dprintf(out, "%s\n", *var);
+        }
+        return 0;
+    }
+    else if(!*cmd->argv[1] || strchr(cmd->argv[1], '='))
+    {
+        fprintf(stderr, "setenv: Invalid variable name\n");
+        return 1;
+    }
+
+    setenv(cmd->argv[1], (cmd->argc == 3) ? cmd->argv[2] : "", 1);
+    return 0;
+}
+
+// Executes the unsetenv command, which removes each variable named by its
+// args. Returns the exit status.
+int unsetenvBuiltin(CMD* cmd)
+{
+    if(cmd->argc < 2)
+    {
+        fprintf(stderr, "unsetenv: Too few arguments\n");
+        return 1;
+    }
+
+    for(int i = 1; i < cmd->argc; i++)
+    {
+        unsetenv(cmd->argv[i]);
+    }
+    return 0;
+}
+
+// the size of the output buffer of echo and history, which is on the stack
+#define OUT_BUF_SIZE (4096)
+
+// entries history writes unless -n says otherwise
+#define HISTORY_DEFAULT_COUNT (20)
+
+// initial size and growth factor of history's array of entries to write
+#define HISTORY_ITEMS_INIT_SIZE (32)
+#define HISTORY_ITEMS_GROWTH_FACTOR (2)
+
+// Adds the len bytes at data to the *used bytes of buf, first writing buf to
+// fd if they don't fit, or writing them straight to fd if they never will.
+// Returns 0, or -1 with errno set.
+static int bufferOut(int fd, char* buf, size_t* used, const char* data,
+                     size_t len)
+{
+    if(*used + len > OUT_BUF_SIZE)
+    {
+        if(!writeAll(fd, buf, *used))
+        {
+            return -1;
+        }
+        *used = 0;
+    }
+    if(len > OUT_BUF_SIZE)
+    {
+        return writeAll(fd, data, len) ? 0 : -1;
+    }
+    memcpy(buf + *used, data, len);
+    *used += len;
+    return 0;
+}
+
+// Blocks SIGPIPE for the calling thread, saving the old signal mask in
+// *oldMask, so that the shell isn't killed for writing to a pipe with no
+// reader
+static void blockPipeSignal(sigset_t* oldMask)
+{
+    sigset_t pipeSignal;
+    sigemptyset(&pipeSignal);
+    sigaddset(&pipeSignal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSignal, oldMask);
+}
+
+// Returns the exit status of the built-in name given status, 0 if its output
+// was written or else -1 with errno set, then restores the signal mask
+// oldMask. A pipe with no reader gives the status of a process killed by
+// SIGPIPE, which is taken back.
+static int outputStatus(const char* name, int status, const sigset_t* oldMask)
+{
+    if(status < 0 && errno == EPIPE)
+    {
+        sigset_t pipeSignal;
+        sigemptyset(&pipeSignal);
+        sigaddset(&pipeSignal, SIGPIPE);
+        struct timespec noWait = { 0, 0 };
+        sigtimedwait(&pipeSignal, NULL, &noWait);
+        status = 128 + SIGPIPE;
+    }
+    else if(status < 0)
+    {
+        perror(name);
+        status = 1;
+    }
+    pthread_sigmask(SIG_SETMASK, oldMask, NULL);
+    return status;
+}
+
+// Executes the echo command with the given args, writing them to out separated
+// by spaces and followed by a newline, unless the first is -n. Returns the
+// exit status: that of a process killed by SIGPIPE if out is a pipe with no
+// reader, as echo would be.
+int echoBuiltin(char** argv, int out)
+{
+    bool newline = !(argv[1] && strcmp(argv[1], "-n") == 0);
+    char buf[OUT_BUF_SIZE];
+    size_t used = 0;
+
+    sigset_t oldMask;
+    blockPipeSignal(&oldMask);
+
+    int status = 0;
+    for(char** arg = argv + 1 + !newline; *arg && status == 0; arg++)
+    {
+        if(arg != argv + 1 + !newline)
+        {
+            status = bufferOut(out, buf, &used, " ", 1);
+        }
+        if(status == 0)
+        {
+            status = bufferOut(out, buf, &used, *arg, strlen(*arg));
+        }
+    }
+    if(status == 0 && newline)
+    {
+        status = bufferOut(out, buf, &used, "\n", 1);
+    }
+    if(status == 0)
+    {
+        status = writeAll(out, buf, used) ? 0 : -1;
+    }
+    return outputStatus("echo", status, &oldMask);
+}
+
+// Executes the history command with the given args, writing the last count
+// entries of the history (or the last count starting with prefix) to out,
+// oldest first, each with its number. Returns the exit status.
+int historyBuiltin(char** argv, int out)
+{
+    unsigned long long count = HISTORY_DEFAULT_COUNT;
+    char** arg = argv + 1;
+    if(arg[0] && strcmp(arg[0], "-n") == 0)
     {
-        int options = O_WRONLY;
-        if(ISAPPEND(cmd->toType))
+        char* end;
+        if(!arg[1] || (count = strtoull(arg[1], &end, 10), *end))
         {
-            options |= O_APPEND;
-            if(!getenv("noclobber") || ISCLOBBER(cmd->toType))
-            {
-                options |= O_CREAT;
-            }
+            arg = NULL;
         }
         else
         {
-            options |= O_CREAT | O_TRUNC;
-            if(getenv("noclobber") && !ISCLOBBER(cmd->toType))
-            {
-                options |= O_EXCL;
-            }
+            arg += 2;
         }
-        
-        if((newStderr = open(cmd->toFile, options, (mode_t)0666)) < 0)
+    }
+    if(!arg || (arg[0] && arg[1]))
+    {
+        fprintf(stderr, "history: Usage: history [-n count] [prefix]\n");
+        return 1;
+    }
+
+    const char* prefix = arg[0] ? arg[0] : "";
+    size_t len = strlen(prefix);
+
+    // collect the entries to write, newest first, by going back through the
+    // chain of those that match
+    size_t itemsSize = HISTORY_ITEMS_INIT_SIZE, nItems = 0;
+    historyItem* items = malloc(sizeof(historyItem) * itemsSize);
+    for(historyItem* before = NULL;
+        nItems < count && findHistory(prefix, len, before, &items[nItems]);
+        before = &items[nItems++])
+    {
+        if(nItems + 1 == itemsSize)
+        {
+            itemsSize *= HISTORY_ITEMS_GROWTH_FACTOR;
+            items = realloc(items, sizeof(historyItem) * itemsSize);
+        }
+    }
+
+    char buf[OUT_BUF_SIZE], number[32];
+    size_t used = 0;
+    sigset_t oldMask;
+    blockPipeSignal(&oldMask);
+
+    int status = 0;
+    for(size_t i = nItems; status == 0 && i-- > 0; )
+    {
+        int numberLen = snprintf(number, sizeof(number), "%6llu  ",
+                                 items[i].number);
+        status = bufferOut(out, buf, &used, number, numberLen);
+        if(status == 0)
+        {
+            status = bufferOut(out, buf, &used, items[i].text, items[i].len);
+        }
+        if(status == 0)
+        {
+            status = bufferOut(out, buf, &used, "\n", 1);
+        }
+    }
+    free(items);
+    if(status == 0)
+    {
+        status = writeAll(out, buf, used) ? 0 : -1;
+    }
+    return outputStatus("history", status, &oldMask);
+}
+
+// Executes the fdcache command with the given args, printing the files held
+// open by the fd cache to out, or with -c closing them. Returns the exit
+// status.
+int fdcache(CMD* cmd, int out)
+{
+    if(cmd->argc > 2 || (cmd->argc == 2 && strcmp(cmd->argv[1], "-c") != 0))
+    {
+        fprintf(stderr, "fdcache: Usage: fdcache [-c]\n");
+        return 1;
+    }
+
+    if(cmd->argc == 2)
+    {
+        closeFdCache();
+    }
+    else
+    {
+        dumpFdCache(out);
+    }
+    return 0;
+}
+
+int execStageBuiltin(char** argv, int out)
+{
+    if(strcmp(argv[0], "history") == 0)
+    {
+        return historyBuiltin(argv, out);
+    }
+    return echoBuiltin(argv, out);
+}
+
+int execBuiltin(CMD* cmd)
+{
+    // cmd->toFile, if opened, and the original stderr
+    int toFd = -1, oldStderr = -1;
+    bool cached = false; // is toFd the fd cache's?
+    
+    // open the file stdout is redirected to, which the built-ins that write
+    // to stdout are passed, and redirect stderr to it if necessary
+    if(cmd->toType != NONE)
+    {
+        if((toFd = openToFile(cmd, O_CLOEXEC, &cached)) < 0)
         {
             perror("eggshell");
             return errno;
         }
-        
+    }
+    int out = (toFd >= 0) ? toFd : STDOUT_FILENO;
+    if(ISERROR(cmd->toType))
+    {
         fflush(stderr);
         oldStderr = dup(2);
-        dup2(newStderr, 2);
-        close(newStderr);
+        dup2(toFd, 2);
     }
     
     int status = 0;
@@ -167,10 +446,38 @@ int execBuiltin(CMD* cmd)
     {
         status = pushd(cmd);
     }
-    else
+    else if(strcmp(cmd->argv[0], "popd") == 0)
     {
         status = popd(cmd);
     }
+    else if(strcmp(cmd->argv[0], "setenv") == 0)
+    {
+        status = setenvBuiltin(cmd, out);
+    }
+    else if(strcmp(cmd->argv[0], "unsetenv") == 0)
+    {
+        status = unsetenvBuiltin(cmd);
+    }
+    else if(strcmp(cmd->argv[0], "fdcache") == 0)
+    {
+        status = fdcache(cmd, out);
+    }
+    else if(strcmp(cmd->argv[0], "batch") == 0)
+    {
+        status = batch(cmd, out);
+    }
+    else if(strcmp(cmd->argv[0], "cache") == 0)
+    {
+        status = cacheCommand(cmd, out);
+    }
+    else if(IS_STAGE_BUILTIN(cmd->argv[0]))
+    {
+        status = execStageBuiltin(cmd->argv, out);
+    }
+    else
+    {
+        status = memstats(cmd, out);
+    }
     
     // redirect stderr back to the original stderr
     if(ISERROR(cmd->toType))
@@ -179,6 +486,10 @@ int execBuiltin(CMD* cmd)
         dup2(oldStderr, 2);
         close(oldStderr);
     }
+    if(toFd >= 0 && !cached)
+    {
+        close(toFd);
+    }
     
     return status;
 }
@@ -1,23 +1,53 @@
 /* 
  * File:   builtinCommands.h
  * Author: Alexander Schurman
+ * Modified by: agent (agent@local)
  *
  * Created on November 20, 2012
  * 
- * Interface for the built-in commands (cd, pushd, popd)
+ * Interface for the built-in commands (cd, pushd, popd, memstats, setenv,
+ * unsetenv, echo, fdcache, batch, cache, history)
  */
 
 #ifndef BUILTINCOMMANDS_H
 #define BUILTINCOMMANDS_H
 
 #include "process.h"
+#include "stack.h"
 
-#define IS_BUILTIN(x) (strcmp(x, "cd")    == 0 || \
-                       strcmp(x, "pushd") == 0 || \
-                       strcmp(x, "popd")  == 0)
+#define IS_BUILTIN(x) (strcmp(x, "cd")       == 0 || \
+                       strcmp(x, "pushd")    == 0 || \
+                       strcmp(x, "popd")     == 0 || \
+                       strcmp(x, "memstats") == 0 || \
+                       strcmp(x, "setenv")   == 0 || \
+                       strcmp(x, "unsetenv") == 0 || \
+                       strcmp(x, "echo")     == 0 || \
+                       strcmp(x, "fdcache")  == 0 || \
+                       strcmp(x, "batch")    == 0 || \
+                       strcmp(x, "cache")    == 0 || \
+                       strcmp(x, "history")  == 0)
+
+// Returns true if x is a built-in that only writes to its standard output,
+// which can run on a thread of the shell as a stage of a pipeline
+#define IS_STAGE_BUILTIN(x) (strcmp(x, "echo")    == 0 || \
+                             strcmp(x, "history") == 0)
+
+// Returns true if x is a built-in that reads its standard input, which runs in
+// a child of its own rather than in the shell as the last stage of a pipeline
+#define IS_FILTER_BUILTIN(x) (strcmp(x, "batch") == 0 || \
+                              strcmp(x, "cache") == 0)
 
 // Executes a built-in command and returns its exit status. The command to
 // execute it determined by cmd->argv[0]
 int execBuiltin(CMD* cmd);
 
+// Executes the built-in with the arguments argv, for which IS_STAGE_BUILTIN()
+// is true, writing its output to out. Safe to call from any thread; it raises
+// no SIGPIPE. Returns the exit status.
+int execStageBuiltin(char** argv, int out);
+
+// Makes pushd and popd use stk as the directory stack; NULL restores the
+// shell's own
+void setDirStack(stack* stk);
+
 #endif
@@ -0,0 +1,112 @@
+/*
+ * File:   builtinStage.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the threaded built-in stages described in builtinStage.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "builtinStage.h"
+#include "builtinCommands.h"
+#include "expand.h"
+#include "profile.h"
+
+#define MEM_SUBSYSTEM MEM_PROCESS
+#include "memStats.h"
+
+struct builtinStage
+{
+    char** argv;    // its arguments, expanded
+    argList* args;  //   and their storage, if they needed expanding
+    int out;        // where it writes
+    pthread_t thread;
+    bool threaded;  // is it running on thread,
+    pid_t pid;      //   or else in this child (if not -1)?
+    int status;     // its wait status, once it's done
+};
+
+// Runs stage, a builtinStage*, and returns NULL
+static void* runStage(void* stage)
+{
+    builtinStage* s = stage;
+    s->status = W_EXITCODE(execStageBuiltin(s->argv, s->out), 0);
+    return NULL;
+}
+
+bool isBuiltinStage(const CMD* cmd)
+{
+    return cmd->type == SIMPLE && !cmd->subst && cmd->fromType == NONE &&
+           cmd->toType == NONE && IS_STAGE_BUILTIN(cmd->argv[0]);
+}
+
+builtinStage* startBuiltinStage(CMD* cmd, int out)
+{
+    builtinStage* stage = malloc(sizeof(builtinStage));
+    stage->argv = cmd->argv;
+    stage->args = NULL;
+    stage->out = out;
+    stage->threaded = false;
+    stage->pid = -1;
+    stage->status = W_EXITCODE(EXIT_FAILURE, 0);
+
+    if(cmd->expand && !(stage->args = expandArgs(cmd->argv)))
+    {
+        return stage;
+    }
+    else if(stage->args)
+    {
+        stage->argv = stage->args->argv;
+    }
+
+    // signals are left to the main thread, which runs the commands
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    stage->threaded = pthread_create(&stage->thread, NULL, runStage, stage)
+                      == 0;
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    if(!stage->threaded && (stage->pid = fork()) == 0)
+    {
+        exit(execStageBuiltin(stage->argv, out));
+    }
+    else if(!stage->threaded && stage->pid < 0)
+    {
+        perror("eggshell");
+    }
+    else if(!stage->threaded)
+    {
+        profileFork();
+    }
+    return stage;
+}
+
+int finishBuiltinStage(builtinStage* stage)
+{
+    if(stage->threaded)
+    {
+        pthread_join(stage->thread, NULL);
+    }
+    else if(stage->pid > 0)
+    {
+        while(waitpid(stage->pid, &stage->status, 0) < 0 && errno == EINTR);
+    }
+
+    int status = stage->status;
+    if(stage->args)
+    {
+        freeArgList(stage->args);
+    }
+    free(stage);
+    return status;
+}
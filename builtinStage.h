@@ -0,0 +1,35 @@
+/*
+ * File:   builtinStage.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for running a built-in stage of a pipeline, such as echo, on a
+ * thread of the shell instead of in a child forked for it. Only built-ins that
+ * just write to their standard output qualify; the rest, like cd and pushd,
+ * still run in a subshell so that they don't affect the shell.
+ */
+
+#ifndef BUILTINSTAGE_H
+#define BUILTINSTAGE_H
+
+#include <stdbool.h>
+#include "parse.h"
+
+// a built-in stage started by startBuiltinStage()
+typedef struct builtinStage builtinStage;
+
+// Returns true if the stage cmd is a built-in that startBuiltinStage() can run
+bool isBuiltinStage(const CMD* cmd);
+
+// Starts the stage cmd, for which isBuiltinStage() is true, on a thread that
+// writes its output to out. Its arguments are expanded first, on this thread.
+// out must stay open until finishBuiltinStage(), and should be closed in any
+// child forked meanwhile. If no thread can be started, the stage is forked
+// after all.
+builtinStage* startBuiltinStage(CMD* cmd, int out);
+
+// Waits for stage to finish and frees it. Returns its wait status.
+int finishBuiltinStage(builtinStage* stage);
+
+#endif
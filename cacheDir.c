@@ -0,0 +1,175 @@
+/*
+ * File:   cacheDir.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the cache directories described in cacheDir.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "cacheDir.h"
+
+#define MEM_SUBSYSTEM MEM_GETLINE
+#include "memStats.h"
+
+// directory under $HOME holding the caches
+#define CACHE_ROOT ".eggshell"
+
+#define ENTRIES_INIT_SIZE (64)
+#define ENTRIES_GROWTH_FACTOR (2)
+
+typedef struct {
+    char* name;
+    unsigned long long size;
+    time_t mtime;
+} cacheEntry;
+
+char* cacheDir(const char* name)
+{
+    const char* home = getenv("HOME");
+    if(!home || !*home)
+    {
+        return NULL;
+    }
+
+    size_t len = strlen(home) + strlen(CACHE_ROOT) + strlen(name) + 3;
+    char* path = malloc(len);
+
+    snprintf(path, len, "%s/%s", home, CACHE_ROOT);
+    if(mkdir(path, 0700) < 0 && errno != EEXIST)
+    {
+        free(path);
+        return NULL;
+    }
+
+    snprintf(path, len, "%s/%s/%s", home, CACHE_ROOT, name);
+    if(mkdir(path, 0700) < 0 && errno != EEXIST)
+    {
+        free(path);
+        return NULL;
+    }
+
+    return path;
+}
+
+unsigned long long cacheHash(const void* data, size_t len,
+                             unsigned long long seed)
+{
+    const char* in = data;
+    unsigned long long h = 0x9E3779B97F4A7C15ULL ^ seed ^ len;
+    size_t i = 0;
+
+    for( ; i + 8 <= len; i += 8)
+    {
+        unsigned long long w;
+        memcpy(&w, in + i, 8);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    for( ; i < len; i++)
+    {
+        h = (h ^ (unsigned char)in[i]) * 0x100000001B3ULL;
+    }
+
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+unsigned long long envNumber(const char* var, unsigned long long def)
+{
+    const char* value = getenv(var);
+    char* end;
+
+    if(!value || !*value)
+    {
+        return def;
+    }
+
+    unsigned long long n = strtoull(value, &end, 10);
+    switch(*end)
+    {
+        case 'G': case 'g': n <<= 10; // fall through
+        case 'M': case 'm': n <<= 10; // fall through
+        case 'K': case 'k': n <<= 10; end++; break;
+    }
+
+    return (*end == '\0' && end != value) ? n : def;
+}
+
+// Orders cache entries from least to most recently modified
+static int compareEntries(const void* a, const void* b)
+{
+    time_t x = ((const cacheEntry*)a)->mtime;
+    time_t y = ((const cacheEntry*)b)->mtime;
+    return (x > y) - (x < y);
+}
+
+void evictCache(const char* dir, unsigned long long maxSize,
+                unsigned long long maxAge)
+{
+    DIR* d = opendir(dir);
+    if(!d)
+    {
+        return;
+    }
+
+    cacheEntry* entries = NULL;
+    size_t nEntries = 0, size = 0;
+    unsigned long long total = 0;
+    time_t now = time(NULL);
+    struct dirent* ent;
+    struct stat st;
+
+    while((ent = readdir(d)) != NULL)
+    {
+        if(ent->d_name[0] == '.' ||
+           fstatat(dirfd(d), ent->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0 ||
+           !S_ISREG(st.st_mode))
+        {
+            continue;
+        }
+
+        if((unsigned long long)(now - st.st_mtime) > maxAge)
+        {
+            unlinkat(dirfd(d), ent->d_name, 0);
+            continue;
+        }
+
+        if(nEntries == size)
+        {
+            size = size ? size * ENTRIES_GROWTH_FACTOR : ENTRIES_INIT_SIZE;
+            entries = realloc(entries, sizeof(cacheEntry) * size);
+        }
+        entries[nEntries].name = strdup(ent->d_name);
+        entries[nEntries].size = st.st_size;
+        entries[nEntries].mtime = st.st_mtime;
+        total += st.st_size;
+        nEntries++;
+    }
+
+    qsort(entries, nEntries, sizeof(cacheEntry), compareEntries);
+    for(size_t i = 0; i < nEntries; i++)
+    {
+        if(total > maxSize)
+        {
+            unlinkat(dirfd(d), entries[i].name, 0);
+            total -= entries[i].size;
+        }
+        free(entries[i].name);
+    }
+
+    free(entries);
+    closedir(d);
+}
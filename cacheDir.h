@@ -0,0 +1,39 @@
+/*
+ * File:   cacheDir.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for the shell's cache directories, which live under
+ * $HOME/.eggshell/, and the environment settings that limit them.
+ */
+
+#ifndef CACHEDIR_H
+#define CACHEDIR_H
+
+#include <stddef.h>
+
+// Returns the malloc'd path of the cache directory $HOME/.eggshell/name,
+// creating it (and $HOME/.eggshell) if necessary. Returns NULL if HOME is not
+// set or the directory can't be created.
+char* cacheDir(const char* name);
+
+// Returns a 64-bit hash of the len bytes at data, taking them a word at a
+// time; different seeds give unrelated hashes
+unsigned long long cacheHash(const void* data, size_t len,
+                             unsigned long long seed);
+
+// Returns the value of the environment variable var, a number with an
+// optional K, M, or G suffix (multiplying it by a power of 1024), or def if
+// var is not set or invalid
+unsigned long long envNumber(const char* var, unsigned long long def);
+
+// Removes the regular files in the cache directory dir that were last modified
+// more than maxAge seconds ago, then the least recently modified of the rest
+// until they total at most maxSize bytes. The caches touch entries they reuse,
+// so this evicts the least recently used. Files whose names start with a dot,
+// which a cache keeps for itself, are left alone.
+void evictCache(const char* dir, unsigned long long maxSize,
+                unsigned long long maxAge);
+
+#endif
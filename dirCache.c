@@ -0,0 +1,230 @@
+/*
+ * File:   dirCache.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the directory listing cache described in dirCache.h
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "dirCache.h"
+
+#define MEM_SUBSYSTEM MEM_PROCESS
+#include "memStats.h"
+
+// the number of listings kept, and the seconds one is trusted for at most
+#define CACHE_ENTRIES (32)
+#define CACHE_TTL (30)
+
+// modification times only advance with the kernel's timer tick, so a
+// directory modified this close to being listed may change again without its
+// time changing; such a listing isn't reused
+#define RACY_NS (20 * 1000 * 1000)
+
+#define DENTS_BUF_SIZE (32 * 1024)
+#define NAMES_INIT_SIZE (64)
+#define TEXT_INIT_SIZE (1024)
+#define GROWTH_FACTOR (2)
+
+// the records getdents64() fills its buffer with
+struct linuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+typedef struct
+{
+    dev_t dev;               // the directory listed
+    ino_t ino;
+    struct timespec mtime;   //   and its modification time when it was
+    time_t listedAt;         // when it was listed
+    bool trusted;            // was it listed well after it was modified?
+    unsigned long lastUse;   // useClock when it was last returned
+    dirListing* listing;     // NULL if the entry is unused
+} listingEntry;
+
+static listingEntry cache[CACHE_ENTRIES];
+static unsigned long useClock = 0;
+
+// Reads the entries of the directory open on fd, other than . and ..
+// Returns them, held once, or NULL if it can't be read.
+static dirListing* readListing(int fd)
+{
+    static char dents[DENTS_BUF_SIZE];
+    size_t textSize = TEXT_INIT_SIZE, textLen = 0;
+    int namesSize = NAMES_INIT_SIZE, n = 0;
+    char* text = malloc(textSize);
+    size_t* offsets = malloc(sizeof(size_t) * namesSize); // names in text
+    unsigned char* types = malloc(namesSize);
+    long got;
+
+    while((got = syscall(SYS_getdents64, fd, dents, sizeof(dents))) > 0)
+    {
+        for(long pos = 0; pos < got; )
+        {
+            struct linuxDirent64* d = (struct linuxDirent64*)(dents + pos);
+            pos += d->d_reclen;
+
+            const char* name = d->d_name;
+            if(name[0] == '.' &&
+               (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            {
+                continue;
+            }
+
+            size_t len = strlen(name) + 1;
+            while(textLen + len > textSize)
+            {
+                textSize *= GROWTH_FACTOR;
+                text = realloc(text, textSize);
+            }
+            if(n == namesSize)
+            {
+                namesSize *= GROWTH_FACTOR;
+                offsets = realloc(offsets, sizeof(size_t) * namesSize);
+                types = realloc(types, namesSize);
+            }
+            memcpy(text + textLen, name, len);
+            offsets[n] = textLen;
+            types[n++] = d->d_type;
+            textLen += len;
+        }
+    }
+
+    if(got < 0)
+    {
+        int error = errno;
+        free(text);
+        free(offsets);
+        free(types);
+        errno = error;
+        return NULL;
+    }
+
+    // the names can only point into the text now that it's done growing
+    dirListing* listing = malloc(sizeof(dirListing));
+    listing->nNames = n;
+    listing->names = malloc(sizeof(char*) * (n + 1));
+    for(int i = 0; i < n; i++)
+    {
+        listing->names[i] = text + offsets[i];
+    }
+    listing->names[n] = NULL;
+    listing->types = types;
+    listing->buf = text;
+    listing->refs = 1;
+    free(offsets);
+    return listing;
+}
+
+// Returns the cache entry to replace: the least recently used
+static listingEntry* victim(void)
+{
+    listingEntry* lru = &cache[0];
+    for(int i = 0; i < CACHE_ENTRIES && lru->listing; i++)
+    {
+        if(!cache[i].listing || cache[i].lastUse < lru->lastUse)
+        {
+            lru = &cache[i];
+        }
+    }
+    return lru;
+}
+
+dirListing* openListing(const char* path)
+{
+    struct stat st;
+    if(stat(path, &st) < 0)
+    {
+        return NULL;
+    }
+
+    time_t now = time(NULL);
+    listingEntry* entry = NULL;
+    for(int i = 0; i < CACHE_ENTRIES; i++)
+    {
+        if(cache[i].listing && cache[i].dev == st.st_dev &&
+           cache[i].ino == st.st_ino)
+        {
+            entry = &cache[i];
+            break;
+        }
+    }
+
+    if(entry && entry->trusted && now - entry->listedAt < CACHE_TTL &&
+       entry->mtime.tv_sec == st.st_mtim.tv_sec &&
+       entry->mtime.tv_nsec == st.st_mtim.tv_nsec)
+    {
+        entry->lastUse = ++useClock;
+        entry->listing->refs++;
+        return entry->listing;
+    }
+
+    // list it (again)
+    struct timespec listedAt;
+    clock_gettime(CLOCK_REALTIME, &listedAt);
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd < 0 || fstat(fd, &st) < 0)
+    {
+        int error = errno;
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+        errno = error;
+        return NULL;
+    }
+    dirListing* listing = readListing(fd);
+    close(fd);
+    if(!listing)
+    {
+        return NULL;
+    }
+
+    if(!entry)
+    {
+        entry = victim();
+    }
+    if(entry->listing)
+    {
+        releaseListing(entry->listing);
+    }
+    long long age = (listedAt.tv_sec - st.st_mtim.tv_sec) * 1000000000LL +
+                    (listedAt.tv_nsec - st.st_mtim.tv_nsec);
+    entry->dev = st.st_dev;
+    entry->ino = st.st_ino;
+    entry->mtime = st.st_mtim;
+    entry->listedAt = listedAt.tv_sec;
+    entry->trusted = age >= RACY_NS;
+    entry->lastUse = ++useClock;
+    entry->listing = listing;
+
+    listing->refs++; // the cache's and the caller's
+    return listing;
+}
+
+void releaseListing(dirListing* listing)
+{
+    if(--listing->refs == 0)
+    {
+        free(listing->names);
+        free(listing->types);
+        free(listing->buf);
+        free(listing);
+    }
+}
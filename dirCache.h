@@ -0,0 +1,34 @@
+/*
+ * File:   dirCache.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for a small cache of directory listings, read with getdents64(),
+ * for matching globs against. A listing is reused as long as its directory's
+ * modification time hasn't changed, so a loop that globs the same directories
+ * over and over costs a stat() per directory instead of a scan. Listings are
+ * keyed by device and inode, so they survive a cd.
+ */
+
+#ifndef DIRCACHE_H
+#define DIRCACHE_H
+
+typedef struct
+{
+    int nNames;           // the number of entries, other than . and ..
+    char** names;         // their names
+    unsigned char* types; // their d_types (DT_UNKNOWN if the file system
+                          //   doesn't say)
+    char* buf;            // storage for the names
+    int refs;             // the number of holders of the listing
+} dirListing;
+
+// Returns the listing of the directory path, which the caller must release
+// with releaseListing(), or NULL (with errno set) if it can't be read
+dirListing* openListing(const char* path);
+
+// Releases a listing returned by openListing()
+void releaseListing(dirListing* listing);
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * File:   eggclient.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Runs a script or command line on an eggshell server (eggshell -S), which
+ * takes on this process's working directory, environment, and standard input,
+ * output, and error, and exits with the status the server returns.
+ *
+ *   eggclient [-s socket] [-c command | script]
+ *
+ * The socket defaults to $EGGSHELL_SOCKET. A command line is plain text; a
+ * script, or standard input if neither is given, is read in the server's
+ * input mode. Exits with 255 if the server can't be reached.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+#include "fullIO.h"
+
+// exit status when the request can't be made
+#define CLIENT_FAILURE (255)
+
+extern char** environ;
+
+// Prints the command-line usage to stderr
+static void usage(char* name)
+{
+    fprintf(stderr, "Usage: %s [-s socket] [-c command | script]\n", name);
+}
+
+// Sends hdr on fd with the nFds descriptors in fds attached. Returns true if
+// successful.
+static bool sendHeader(int fd, const requestHeader* hdr, const int* fds,
+                       int nFds)
+{
+    char control[CMSG_SPACE(sizeof(int) * REQUEST_MAX_FDS)];
+    struct iovec iov = { (void*)hdr, sizeof(requestHeader) };
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(msg));
+    memset(control, 0, sizeof(control));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * nFds);
+
+    struct cmsghdr* c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(sizeof(int) * nFds);
+    memcpy(CMSG_DATA(c), fds, sizeof(int) * nFds);
+
+    ssize_t n;
+    while((n = sendmsg(fd, &msg, 0)) < 0 && errno == EINTR);
+    if(n < 0)
+    {
+        return false;
+    }
+
+    // the descriptors went with the first byte; send whatever is left
+    return writeAll(fd, (const char*)hdr + n, sizeof(requestHeader) - n);
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = getenv("EGGSHELL_SOCKET");
+    char* command = NULL;
+    int fds[REQUEST_MAX_FDS] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+    int nFds = 3;
+    int opt;
+
+    while((opt = getopt(argc, argv, "s:c:")) != -1)
+    {
+        switch(opt)
+        {
+            case 's':
+                path = optarg;
+                break;
+
+            case 'c':
+                command = optarg;
+                break;
+
+            default:
+                usage(argv[0]);
+                return CLIENT_FAILURE;
+        }
+    }
+
+    struct sockaddr_un addr;
+    if(!path || strlen(path) >= sizeof(addr.sun_path) ||
+       (command && optind < argc))
+    {
+        usage(argv[0]);
+        return CLIENT_FAILURE;
+    }
+
+    if(optind < argc) // send the script itself
+    {
+        if((fds[nFds++] = open(argv[optind], O_RDONLY)) < 0)
+        {
+            perror(argv[optind]);
+            return CLIENT_FAILURE;
+        }
+    }
+
+    char* cwd = getcwd(NULL, 0);
+    if(!cwd)
+    {
+        perror("getcwd");
+        return CLIENT_FAILURE;
+    }
+
+    requestHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, REQUEST_MAGIC, sizeof(hdr.magic));
+    hdr.cwdLen = strlen(cwd);
+    for(char** var = environ; *var; var++)
+    {
+        hdr.envLen += strlen(*var) + 1;
+    }
+    hdr.commandLen = command ? strlen(command) : 0;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+        perror(path);
+        return CLIENT_FAILURE;
+    }
+
+    bool sent = sendHeader(fd, &hdr, fds, nFds) &&
+                writeAll(fd, cwd, hdr.cwdLen);
+    for(char** var = environ; sent && *var; var++)
+    {
+        sent = writeAll(fd, *var, strlen(*var) + 1);
+    }
+    if(sent && command)
+    {
+        sent = writeAll(fd, command, hdr.commandLen);
+    }
+
+    // the server has its own copies of the descriptors; wait for its status
+    int status;
+    if(!sent || !readAll(fd, &status, sizeof(status)))
+    {
+        fprintf(stderr, "%s: no reply from server\n", argv[0]);
+        return CLIENT_FAILURE;
+    }
+    return status;
+}
@@ -0,0 +1,294 @@
+/*
+ * File:   eggencode.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Encodes text as Eggshell white-space input using the bit layout in getwc.h,
+ * and generates synthetic scripts for benchmarks and stress tests.
+ *
+ *   eggencode [string ...]   encodes the strings, separated by spaces, or
+ *                            standard input if none are given
+ *   eggencode -g [options]   generates a script and encodes it
+ *
+ * Generator options:
+ *   -n lines     number of command lines (default 1000)
+ *   -l length    approximate characters per command line (default 60)
+ *   -o density   probability that a word is followed by ;, &&, or || rather
+ *                than another word (default 0.1)
+ *   -d depth     stages per pipeline (default 1)
+ *   -h size      lines per here document; 0 for none (default 0)
+ *   -f percent   percentage of command lines with a here document (default 10)
+ *   -s seed      random seed (default 1)
+ *   -t           write the script as plain text instead of encoding it
+ *
+ * Encoding is table driven: each ASCII character indexes an 8-byte entry
+ * holding its 7 white-space characters, which is stored with a single 64-bit
+ * copy, so the bit expansion runs at memory speed without a loop per bit.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include "getwc.h"
+
+// characters encoded per output block
+#define BLOCK_SIZE (64 * 1024)
+
+// the expansion of each ASCII character; the eighth byte is padding so that
+// each entry can be copied as one 8-byte word
+static char encodeTable[128][8];
+
+static bool plainText = false; // write text without encoding it?
+static char outBlock[BLOCK_SIZE * WS_BITS + 8];
+
+// Fills encodeTable
+static void initEncodeTable(void)
+{
+    for(int c = 0; c < 128; c++)
+    {
+        for(int bit = 0; bit < WS_BITS; bit++)
+        {
+            encodeTable[c][bit] =
+                (c & (1 << (WS_BITS - 1 - bit))) ? WS_ONE : WS_ZERO;
+        }
+        encodeTable[c][WS_BITS] = '\0';
+    }
+}
+
+// Writes the encoding of the len chars at text to stdout. Exits in error if
+// text contains a non-ASCII character.
+static void encode(const char* text, size_t len)
+{
+    if(plainText)
+    {
+        fwrite(text, 1, len, stdout);
+        return;
+    }
+
+    while(len > 0)
+    {
+        size_t n = (len < BLOCK_SIZE) ? len : BLOCK_SIZE;
+        char* out = outBlock;
+
+        for(size_t i = 0; i < n; i++)
+        {
+            unsigned char c = text[i];
+            if(c > 127)
+            {
+                fprintf(stderr, "eggencode: Invalid character; must be "
+                        "ASCII\n");
+                exit(EXIT_FAILURE);
+            }
+            memcpy(out, encodeTable[c], 8); // a single 8-byte store
+            out += WS_BITS;
+        }
+
+        fwrite(outBlock, 1, out - outBlock, stdout);
+        text += n;
+        len -= n;
+    }
+}
+
+// Encodes standard input to stdout
+static void encodeStdin(void)
+{
+    static char inBlock[BLOCK_SIZE];
+    ssize_t n;
+
+    while((n = read(STDIN_FILENO, inBlock, BLOCK_SIZE)) > 0)
+    {
+        encode(inBlock, n);
+    }
+    if(n < 0)
+    {
+        perror("eggencode");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*******************************************************************************
+ ***************************** Workload Generator ******************************
+ ******************************************************************************/
+
+typedef struct {
+    long lines;        // number of command lines
+    int length;        // approximate characters per command line
+    double density;    // probability that a word is followed by an operator
+    int depth;         // stages per pipeline
+    int hereSize;      // lines per here document
+    int herePercent;   // percentage of command lines with a here document
+} workload;
+
+static unsigned long long rngState;
+
+// Returns the next value of a xorshift64* generator, so scripts generated with
+// the same seed are identical everywhere
+static unsigned long long nextRandom(void)
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 2685821657736338717ULL;
+}
+
+// Returns a uniformly distributed double in [0, 1)
+static double randomUnit(void)
+{
+    return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static const char* words[] = {
+    "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel",
+    "india", "juliet", "kilo", "lima", "mike", "november", "oscar", "papa"
+};
+static const int nWords = sizeof(words) / sizeof(words[0]);
+
+// stages used after the first stage of a pipeline
+static const char* filters[] = { "cat", "tr a-z A-Z", "wc -c", "sort" };
+static const int nFilters = sizeof(filters) / sizeof(filters[0]);
+
+static const char* operators[] = { " ; ", " && ", " || " };
+static const int nOperators = sizeof(operators) / sizeof(operators[0]);
+
+// Appends str to the line being generated in buf at *len
+static void append(char* buf, size_t* len, const char* str)
+{
+    size_t n = strlen(str);
+    memcpy(buf + *len, str, n);
+    *len += n;
+}
+
+// Appends the stages after the first of a pipeline and its redirection
+static void appendPipelineTail(char* buf, size_t* len, const workload* w)
+{
+    for(int i = 1; i < w->depth; i++)
+    {
+        append(buf, len, " | ");
+        append(buf, len, filters[nextRandom() % nFilters]);
+    }
+    append(buf, len, " > /dev/null");
+}
+
+// Writes the script described by w to stdout
+static void generate(const workload* w)
+{
+    // room for a line: its words, plus the longest pipeline tail, operator,
+    // and word that can follow the last word before the length is reached
+    size_t size = w->length + (w->depth + 4) * 32 + 64;
+    char* line = malloc(size);
+
+    for(long n = 0; n < w->lines; n++)
+    {
+        bool hereDoc = w->hereSize > 0 &&
+                       (int)(nextRandom() % 100) < w->herePercent;
+        size_t len = 0;
+
+        // a here document can only feed the first stage of a pipeline, and
+        // only one per line, so such lines are a single cat pipeline
+        append(line, &len, hereDoc ? "cat <<EOF" : "echo");
+        while(!hereDoc && len < (size_t)w->length)
+        {
+            append(line, &len, " ");
+            append(line, &len, words[nextRandom() % nWords]);
+
+            if(len < (size_t)w->length && randomUnit() < w->density)
+            {
+                appendPipelineTail(line, &len, w);
+                append(line, &len, operators[nextRandom() % nOperators]);
+                append(line, &len, "echo");
+            }
+        }
+        appendPipelineTail(line, &len, w);
+        append(line, &len, "\n");
+        encode(line, len);
+
+        for(int i = 0; hereDoc && i < w->hereSize; i++)
+        {
+            len = 0;
+            for(int j = 0; j == 0 || len < (size_t)w->length; j++)
+            {
+                append(line, &len, j ? " " : "");
+                append(line, &len, words[nextRandom() % nWords]);
+            }
+            append(line, &len, "\n");
+            encode(line, len);
+        }
+        if(hereDoc)
+        {
+            encode("EOF\n", 4);
+        }
+    }
+
+    free(line);
+}
+
+// Prints the command-line usage to stderr
+static void usage(char* name)
+{
+    fprintf(stderr, "Usage: %s [string ...]\n"
+            "       %s -g [-n lines] [-l length] [-o density] [-d depth]\n"
+            "             [-h size] [-f percent] [-s seed] [-t]\n",
+            name, name);
+}
+
+int main(int argc, char** argv)
+{
+    workload w = { 1000, 60, 0.1, 1, 0, 10 };
+    bool generating = false;
+    int opt;
+
+    rngState = 1;
+    while((opt = getopt(argc, argv, "gn:l:o:d:h:f:s:t")) != -1)
+    {
+        switch(opt)
+        {
+            case 'g': generating = true;                       break;
+            case 'n': w.lines = atol(optarg);                  break;
+            case 'l': w.length = atoi(optarg);                 break;
+            case 'o': w.density = atof(optarg);                break;
+            case 'd': w.depth = atoi(optarg);                  break;
+            case 'h': w.hereSize = atoi(optarg);               break;
+            case 'f': w.herePercent = atoi(optarg);            break;
+            case 's': rngState = strtoull(optarg, NULL, 0);    break;
+            case 't': plainText = true;                        break;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if(w.length < 1 || w.depth < 1 || w.hereSize < 0 || rngState == 0)
+    {
+        fprintf(stderr, "eggencode: length and depth must be positive, size "
+                "nonnegative, and seed nonzero\n");
+        return EXIT_FAILURE;
+    }
+
+    initEncodeTable();
+
+    if(generating)
+    {
+        generate(&w);
+    }
+    else if(optind == argc)
+    {
+        encodeStdin();
+    }
+    else
+    {
+        for(int i = optind; i < argc; i++)
+        {
+            encode(argv[i], strlen(argv[i]));
+            if(i + 1 < argc)
+            {
+                encode(" ", 1);
+            }
+        }
+    }
+
+    return fflush(stdout) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
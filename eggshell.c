@@ -0,0 +1,910 @@
+/*
+ * File:   eggshell.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of libeggshell as described in eggshell.h. A context's
+ * environment is a vector of strings that environ points to in the children
+ * that run its commands, so getenv() and the programs they run see it; in the
+ * host, $? and the built-ins that set variables change the vector directly.
+ *
+ * A job started by eggStart() walks the command tree of each line as process()
+ * would, but forks each pipeline off instead of waiting for it, and learns of
+ * its exit through a pidfd held in the job's epoll descriptor. eggRun() runs
+ * such a job and waits for it.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include "eggshell.h"
+#include "getLine.h"
+#include "getwc.h"
+#include "parse.h"
+#include "process.h"
+#include "builtinCommands.h"
+#include "stack.h"
+#include "expand.h"
+#include "fullIO.h"
+
+#define MEM_SUBSYSTEM MEM_PROCESS
+#include "memStats.h"
+
+#define ENV_INIT_SIZE (32)
+#define ENV_GROWTH_FACTOR (2)
+#define SCRIPT_INIT_SIZE (16)
+#define SCRIPT_GROWTH_FACTOR (2)
+#define EXPAND_INIT_SIZE (256)
+#define EXPAND_GROWTH_FACTOR (2)
+
+// number of standard descriptors a context has
+#define STD_FDS (3)
+
+struct eggContext {
+    int fds[STD_FDS]; // standard input, output, and error
+    int cwd;          // working directory
+    stack* dirStack;  // directory stack for pushd and popd
+    bool normal;      // read plain text rather than white space?
+    char** env;       // environment, terminated by NULL
+    size_t envLen;    //   number of strings in env
+    size_t envSize;   //   malloc'd size of env
+};
+
+struct eggScript {
+    CMD** cmds;  // command lines in order; NULL for empty lines
+    size_t nCmds;
+};
+
+struct eggJob {
+    eggContext* ctx;
+    const eggScript* script;
+    size_t line;          // next line of script to start
+    CMD* rest;            // what's left of the line after andOr
+    CMD* andOr;           // the <and-or> being run
+    pid_t pid;            // the pipeline running, or -1 if none
+    int pidFd;            //   and its pidfd
+    int epollFd;          // watches pidFd; returned by eggJobFd()
+    int status;           // status of the last pipeline
+    bool done;            // finished?
+    eggCallback callback; // called when done
+    void* arg;            //   with this
+};
+
+extern char** environ;
+
+// held while a script is parsed, since the parser keeps its state in globals
+static pthread_mutex_t parseLock = PTHREAD_MUTEX_INITIALIZER;
+
+// the context a script is being parsed in, the rest of the script, and
+// whether it has a syntax error
+static eggContext* parsing;
+static const char* parsePos;
+static bool parseFailed;
+
+// Returns the index in ctx->env of the variable name, or ctx->envLen if it is
+// not set
+static size_t findVar(const eggContext* ctx, const char* name)
+{
+    size_t len = strlen(name);
+    size_t i;
+    for(i = 0; i < ctx->envLen; i++)
+    {
+        if(strncmp(ctx->env[i], name, len) == 0 && ctx->env[i][len] == '=')
+        {
+            break;
+        }
+    }
+    return i;
+}
+
+eggContext* eggNewContext(int in, int out, int err)
+{
+    eggContext* ctx = malloc(sizeof(eggContext));
+    if(!ctx)
+    {
+        return NULL;
+    }
+
+    ctx->fds[0] = in;
+    ctx->fds[1] = out;
+    ctx->fds[2] = err;
+    if((ctx->cwd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+    {
+        free(ctx);
+        return NULL;
+    }
+    ctx->dirStack = mallocStack();
+    ctx->normal = false;
+
+    ctx->envLen = 0;
+    ctx->envSize = ENV_INIT_SIZE;
+    for(char** var = environ; *var; var++, ctx->envLen++);
+    while(ctx->envSize <= ctx->envLen)
+    {
+        ctx->envSize *= ENV_GROWTH_FACTOR;
+    }
+    ctx->env = malloc(sizeof(char*) * ctx->envSize);
+    for(size_t i = 0; i < ctx->envLen; i++)
+    {
+        ctx->env[i] = strdup(environ[i]);
+    }
+    ctx->env[ctx->envLen] = NULL;
+
+    return ctx;
+}
+
+void eggFreeContext(eggContext* ctx)
+{
+    if(!ctx)
+    {
+        return;
+    }
+
+    for(size_t i = 0; i < ctx->envLen; i++)
+    {
+        free(ctx->env[i]);
+    }
+    free(ctx->env);
+    freeStack(ctx->dirStack);
+    close(ctx->cwd);
+    free(ctx);
+}
+
+void eggSetNormalInput(eggContext* ctx, int normal)
+{
+    ctx->normal = (normal != 0);
+}
+
+void eggSetVar(eggContext* ctx, const char* name, const char* value)
+{
+    size_t i = findVar(ctx, name);
+
+    if(!value) // remove name, keeping env terminated
+    {
+        if(i < ctx->envLen)
+        {
+            free(ctx->env[i]);
+            ctx->env[i] = ctx->env[--ctx->envLen];
+            ctx->env[ctx->envLen] = NULL;
+        }
+        return;
+    }
+
+    size_t len = strlen(name) + strlen(value) + 2;
+    char* var = malloc(len);
+    snprintf(var, len, "%s=%s", name, value);
+
+    if(i < ctx->envLen)
+    {
+        free(ctx->env[i]);
+        ctx->env[i] = var;
+        return;
+    }
+
+    if(ctx->envLen + 1 == ctx->envSize)
+    {
+        ctx->envSize *= ENV_GROWTH_FACTOR;
+        ctx->env = realloc(ctx->env, sizeof(char*) * ctx->envSize);
+    }
+    ctx->env[ctx->envLen++] = var;
+    ctx->env[ctx->envLen] = NULL;
+}
+
+const char* eggGetVar(eggContext* ctx, const char* name)
+{
+    size_t i = findVar(ctx, name);
+    return (i < ctx->envLen) ? ctx->env[i] + strlen(name) + 1 : NULL;
+}
+
+// Reports the error in errno on ctx's standard error. Returns errno.
+static int reportErrno(eggContext* ctx)
+{
+    int error = errno;
+    dprintf(ctx->fds[2], "eggshell: %s\n", strerror(error));
+    return error;
+}
+
+// Returns the next malloc'd line of the script being parsed, including its
+// newline, or NULL at its end; the line source while parsing
+static char* nextLine(void)
+{
+    if(*parsePos == '\0')
+    {
+        return NULL;
+    }
+
+    const char* end = strchr(parsePos, '\n');
+    size_t len = end ? (size_t)(end - parsePos) + 1 : strlen(parsePos);
+    char* line = malloc(len + 1);
+    memcpy(line, parsePos, len);
+    line[len] = '\0';
+    parsePos += len;
+    return line;
+}
+
+// Reports a syntax error on the standard error of the context being parsed
+// in; the parse error handler while parsing
+static void reportError(const char* msg)
+{
+    parseFailed = true;
+    dprintf(parsing->fds[2], "%s", msg);
+}
+
+// Returns the value of the variable name in the context being parsed in; how
+// here documents look up their variables while parsing
+static const char* parseVar(const char* name)
+{
+    return eggGetVar(parsing, name);
+}
+
+eggScript* eggParse(eggContext* ctx, const char* buf, size_t len)
+{
+    // decode the whole script first, so lines are just split off of it
+    char* text;
+    if(ctx->normal)
+    {
+        text = malloc(len + 1);
+        memcpy(text, buf, len);
+        text[len] = '\0';
+    }
+    else
+    {
+        text = malloc(len / WS_BITS + 1);
+        text[decodeWhitespace(buf, len / WS_BITS, text)] = '\0';
+    }
+
+    eggScript* script = malloc(sizeof(eggScript));
+    size_t size = SCRIPT_INIT_SIZE;
+    script->cmds = malloc(sizeof(CMD*) * size);
+    script->nCmds = 0;
+
+    pthread_mutex_lock(&parseLock);
+    parsing = ctx;
+    parsePos = text;
+    parseFailed = false;
+    setLineSource(nextLine);
+    setParseErrorHandler(reportError);
+    setParseVarLookup(parseVar);
+
+    char* line;
+    while(!parseFailed && (line = getJoinedLine(stdin)) != NULL)
+    {
+        token* list = tokenize(line);
+        CMD* cmd = list ? parse(list) : NULL;
+
+        if(script->nCmds == size)
+        {
+            size *= SCRIPT_GROWTH_FACTOR;
+            script->cmds = realloc(script->cmds, sizeof(CMD*) * size);
+        }
+        script->cmds[script->nCmds++] = cmd;
+
+        freeList(list);
+        free(line);
+    }
+
+    setParseVarLookup(NULL);
+    setParseErrorHandler(NULL);
+    setLineSource(NULL);
+    parsing = NULL;
+    pthread_mutex_unlock(&parseLock);
+    free(text);
+
+    if(parseFailed)
+    {
+        eggFreeScript(script);
+        return NULL;
+    }
+    return script;
+}
+
+int eggRun(eggContext* ctx, const eggScript* script)
+{
+    eggJob* job = eggStart(ctx, script, NULL, NULL);
+    if(!job)
+    {
+        return reportErrno(ctx);
+    }
+
+    // wait for each pipeline of the job in turn
+    struct pollfd fd = { .fd = eggJobFd(job), .events = POLLIN };
+    int status;
+    while(!eggPoll(job, &status))
+    {
+        poll(&fd, 1, -1);
+    }
+    eggFreeJob(job);
+
+    return status;
+}
+
+void eggFreeScript(eggScript* script)
+{
+    if(!script)
+    {
+        return;
+    }
+
+    for(size_t i = 0; i < script->nCmds; i++)
+    {
+        freeCMD(script->cmds[i]);
+    }
+    free(script->cmds);
+    free(script);
+}
+
+// Makes this child of the host take on ctx's descriptors, working directory,
+// environment, and directory stack
+static void applyContext(eggContext* ctx)
+{
+    for(int i = 0; i < STD_FDS; i++)
+    {
+        dup2(ctx->fds[i], i);
+    }
+    if(fchdir(ctx->cwd) < 0)
+    {
+        perror("eggshell");
+    }
+    environ = ctx->env;
+    setDirStack(ctx->dirStack);
+}
+
+// Runs cmd in ctx in this child of the host, without returning
+static void runInChild(eggContext* ctx, CMD* cmd)
+{
+    applyContext(ctx);
+    if(cmd->type == SIMPLE && !cmd->subst && !cmd->expand &&
+       !IS_BUILTIN(cmd->argv[0]))
+    {
+        execSimple(cmd); // no need for a second fork
+    }
+    exit(process(cmd));
+}
+
+// Forks a child of the host that runs cmd in ctx. Returns its pid, or -1.
+static pid_t forkInContext(eggContext* ctx, CMD* cmd)
+{
+    fflush(NULL);
+    pid_t pid = fork();
+    if(pid == 0)
+    {
+        runInChild(ctx, cmd);
+    }
+    return pid;
+}
+
+// Runs cmd in ctx in the background, through an intermediate process that
+// exits at once, so that nothing is left for the job to reap
+static void startBackground(eggContext* ctx, CMD* cmd)
+{
+    fflush(NULL);
+    pid_t pid = fork();
+    if(pid == 0)
+    {
+        if(fork() == 0)
+        {
+            runInChild(ctx, cmd);
+        }
+        _exit(EXIT_SUCCESS);
+    }
+
+    if(pid < 0)
+    {
+        reportErrno(ctx);
+        return;
+    }
+    while(waitpid(pid, NULL, 0) < 0 && errno == EINTR);
+}
+
+// Returns true if cmd is, on its own, a built-in that changes the shell it
+// runs in, which runs against the context rather than in a child
+static bool isContextBuiltin(CMD* cmd)
+{
+    if(cmd->type != SIMPLE || cmd->subst)
+    {
+        return false;
+    }
+
+    const char* name = cmd->argv[0];
+    return strcmp(name, "cd")       == 0 || strcmp(name, "pushd")    == 0 ||
+           strcmp(name, "popd")     == 0 || strcmp(name, "setenv")   == 0 ||
+           strcmp(name, "unsetenv") == 0;
+}
+
+// Opens the file that cmd redirects its output to, relative to ctx's working
+// directory, as openToFile() does. Returns the descriptor, or -1 with errno
+// set.
+static int openToFileAt(eggContext* ctx, CMD* cmd)
+{
+    bool noclobber = eggGetVar(ctx, "noclobber") && !ISCLOBBER(cmd->toType);
+    int flags = O_WRONLY | O_CLOEXEC;
+    if(ISAPPEND(cmd->toType))
+    {
+        flags |= O_APPEND | (noclobber ? 0 : O_CREAT);
+    }
+    else
+    {
+        flags |= O_CREAT | O_TRUNC | (noclobber ? O_EXCL : 0);
+    }
+    return openat(ctx->cwd, cmd->toFile, flags, (mode_t)0666);
+}
+
+// Expands the arguments of cmd in a child of the host that takes on ctx, as
+// its command substitutions must run there, and that sends them back. Returns
+// them as a malloc'd vector, terminated by NULL, of strings in the malloc'd
+// *buf, and sets *argc; or returns NULL, the child having reported an error.
+static char** expandInContext(eggContext* ctx, CMD* cmd, int* argc,
+                              char** buf)
+{
+    int fd[2];
+    if(pipe2(fd, O_CLOEXEC) < 0)
+    {
+        reportErrno(ctx);
+        return NULL;
+    }
+
+    fflush(NULL);
+    pid_t pid = fork();
+    if(pid == 0)
+    {
+        close(fd[0]);
+        applyContext(ctx);
+        argList* args = expandArgs(cmd->argv);
+        bool sent = (args != NULL);
+        for(int i = 0; sent && i < args->argc; i++)
+        {
+            sent = writeAll(fd[1], args->argv[i], strlen(args->argv[i]) + 1);
+        }
+        _exit(sent ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    close(fd[1]);
+    if(pid < 0)
+    {
+        reportErrno(ctx);
+        close(fd[0]);
+        return NULL;
+    }
+
+    // each argument comes with its null
+    size_t size = EXPAND_INIT_SIZE, len = 0;
+    *buf = malloc(size);
+    for(ssize_t n; (n = read(fd[0], *buf + len, size - len)) != 0; )
+    {
+        if(n > 0 && (len += n) == size)
+        {
+            size *= EXPAND_GROWTH_FACTOR;
+            *buf = realloc(*buf, size);
+        }
+        else if(n < 0 && errno != EINTR)
+        {
+            break;
+        }
+    }
+    close(fd[0]);
+
+    int status;
+    while(waitpid(pid, &status, 0) < 0 && errno == EINTR);
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+    {
+        free(*buf);
+        return NULL;
+    }
+
+    *argc = 0;
+    for(size_t i = 0; i < len; i++)
+    {
+        *argc += ((*buf)[i] == '\0');
+    }
+    char** argv = malloc(sizeof(char*) * (*argc + 1));
+    char* arg = *buf;
+    for(int i = 0; i < *argc; i++, arg += strlen(arg) + 1)
+    {
+        argv[i] = arg;
+    }
+    argv[*argc] = NULL;
+    return argv;
+}
+
+// Changes ctx's working directory to dir, relative to it. Returns 0, or -1
+// with errno set.
+static int changeDir(eggContext* ctx, const char* dir)
+{
+    int fd = openat(ctx->cwd, dir ? dir : "",
+                    O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return -1;
+    }
+    close(ctx->cwd);
+    ctx->cwd = fd;
+    return 0;
+}
+
+// Returns the malloc'd path of ctx's working directory, or NULL with errno
+// set
+static char* dirPath(eggContext* ctx)
+{
+    char link[32];
+    snprintf(link, sizeof(link), "/proc/self/fd/%d", ctx->cwd);
+    char* path = malloc(PATH_MAX + 1);
+    ssize_t len = readlink(link, path, PATH_MAX);
+    if(len < 0)
+    {
+        free(path);
+        return NULL;
+    }
+    path[len] = '\0';
+    return path;
+}
+
+// Executes cd with the arguments argv in ctx, writing errors to err, as cd()
+// does in the shell. Returns the exit status.
+static int cdInContext(eggContext* ctx, int argc, char** argv, int err)
+{
+    if(argc > 2)
+    {
+        dprintf(err, "cd: Too many arguments\n");
+        return 1;
+    }
+    else if(changeDir(ctx, (argc == 2) ? argv[1] : eggGetVar(ctx, "HOME")) < 0)
+    {
+        int error = errno;
+        dprintf(err, "cd: %s\n", strerror(error));
+        return error;
+    }
+    return 0;
+}
+
+// Executes pushd with the arguments argv in ctx, writing errors to err, as
+// pushd() does in the shell. Returns the exit status.
+static int pushdInContext(eggContext* ctx, int argc, char** argv, int err)
+{
+    if(argc > 2)
+    {
+        dprintf(err, "pushd: Too many arguments\n");
+        return 1;
+    }
+    else if(argc < 2)
+    {
+        dprintf(err, "pushd: No directory arg given\n");
+        return 1;
+    }
+
+    char* currentDir = dirPath(ctx);
+    if(!currentDir)
+    {
+        int error = errno;
+        dprintf(err, "pushd: getcwd failed\n");
+        return error;
+    }
+    else if(changeDir(ctx, argv[1]) < 0)
+    {
+        int error = errno;
+        free(currentDir);
+        dprintf(err, "pushd: chdir failed\n");
+        return error;
+    }
+    stackPush(ctx->dirStack, currentDir);
+    free(currentDir);
+    return 0;
+}
+
+// Executes popd with the arguments argv in ctx, writing errors to err, as
+// popd() does in the shell. Returns the exit status.
+static int popdInContext(eggContext* ctx, int argc, int err)
+{
+    if(argc > 1)
+    {
+        dprintf(err, "popd: Too many arguments\n");
+        return 1;
+    }
+
+    char* dir = stackPop(ctx->dirStack);
+    if(!dir)
+    {
+        dprintf(err, "popd: Empty directory stack\n");
+        return 1;
+    }
+    int status = 0;
+    if(changeDir(ctx, dir) < 0)
+    {
+        status = errno;
+        dprintf(err, "popd: chdir failed\n");
+    }
+    free(dir);
+    return status;
+}
+
+// Executes setenv with the arguments argv in ctx, writing its output to out
+// and errors to err, as setenvBuiltin() does in the shell. Returns the exit
+// status.
+static int setenvInContext(eggContext* ctx, int argc, char** argv, int out,
+                           int err)
+{
+    if(argc > 3)
+    {
+        dprintf(err, "setenv: Too many arguments\n");
+        return 1;
+    }
+    else if(argc == 1)
+    {
+        for(size_t i = 0; i < ctx->envLen; i++)
+        {
+            dprintf(out, "%s\n", ctx->env[i]);
+        }
+        return 0;
+    }
+    else if(!*argv[1] || strchr(argv[1], '='))
+    {
+        dprintf(err, "setenv: Invalid variable name\n");
+        return 1;
+    }
+
+    eggSetVar(ctx, argv[1], (argc == 3) ? argv[2] : "");
+    return 0;
+}
+
+// Executes unsetenv with the arguments argv in ctx, writing errors to err, as
+// unsetenvBuiltin() does in the shell. Returns the exit status.
+static int unsetenvInContext(eggContext* ctx, int argc, char** argv, int err)
+{
+    if(argc < 2)
+    {
+        dprintf(err, "unsetenv: Too few arguments\n");
+        return 1;
+    }
+
+    for(int i = 1; i < argc; i++)
+    {
+        eggSetVar(ctx, argv[i], NULL);
+    }
+    return 0;
+}
+
+// Runs the built-in cmd, for which isContextBuiltin() is true, against ctx
+// rather than the process: its output and errors go to ctx's descriptors, or
+// where cmd redirects them. Returns its exit status.
+static int runBuiltin(eggContext* ctx, CMD* cmd)
+{
+    int out = ctx->fds[1], err = ctx->fds[2], toFd = -1;
+    if(cmd->toType != NONE)
+    {
+        if((toFd = openToFileAt(ctx, cmd)) < 0)
+        {
+            return reportErrno(ctx);
+        }
+        out = toFd;
+        err = ISERROR(cmd->toType) ? toFd : err;
+    }
+
+    int argc = cmd->argc;
+    char** argv = cmd->argv;
+    char* buf = NULL; // what argv points into, if expanded
+    int status;
+    if(cmd->expand && !(argv = expandInContext(ctx, cmd, &argc, &buf)))
+    {
+        status = 1;
+    }
+    else if(strcmp(argv[0], "cd") == 0)
+    {
+        status = cdInContext(ctx, argc, argv, err);
+    }
+    else if(strcmp(argv[0], "pushd") == 0)
+    {
+        status = pushdInContext(ctx, argc, argv, err);
+    }
+    else if(strcmp(argv[0], "popd") == 0)
+    {
+        status = popdInContext(ctx, argc, err);
+    }
+    else if(strcmp(argv[0], "setenv") == 0)
+    {
+        status = setenvInContext(ctx, argc, argv, out, err);
+    }
+    else
+    {
+        status = unsetenvInContext(ctx, argc, argv, err);
+    }
+
+    if(buf)
+    {
+        free(argv);
+        free(buf);
+    }
+    if(toFd >= 0)
+    {
+        close(toFd);
+    }
+    return status;
+}
+
+// Records status as that of job's last pipeline, and picks the rest of the
+// <and-or> to run, if any, as && or || call for
+static void finishPipeline(eggJob* job, int status)
+{
+    char statusStr[12];
+    snprintf(statusStr, sizeof(statusStr), "%d", status);
+    eggSetVar(job->ctx, "?", statusStr);
+
+    CMD* node = job->andOr;
+    job->status = status;
+    if(node->type == SEP_AND)
+    {
+        job->andOr = (status == 0) ? node->right : NULL;
+    }
+    else if(node->type == SEP_OR)
+    {
+        job->andOr = (status != 0) ? node->right : NULL;
+    }
+    else
+    {
+        job->andOr = NULL;
+    }
+}
+
+// Starts pipeline, the next to run in job, watching for its exit
+static void startPipeline(eggJob* job, CMD* pipeline)
+{
+    if(isContextBuiltin(pipeline))
+    {
+        finishPipeline(job, runBuiltin(job->ctx, pipeline));
+        return;
+    }
+
+    if((job->pid = forkInContext(job->ctx, pipeline)) < 0)
+    {
+        finishPipeline(job, reportErrno(job->ctx));
+        return;
+    }
+
+    struct epoll_event event = { .events = EPOLLIN };
+    job->pidFd = syscall(SYS_pidfd_open, job->pid, 0);
+    if(job->pidFd < 0 ||
+       epoll_ctl(job->epollFd, EPOLL_CTL_ADD, job->pidFd, &event) < 0)
+    {
+        // no way to be told when it exits, so wait for it now
+        int status;
+        while(waitpid(job->pid, &status, 0) < 0 && errno == EINTR);
+        if(job->pidFd >= 0)
+        {
+            close(job->pidFd);
+        }
+        job->pid = -1;
+        finishPipeline(job, GET_STATUS(status));
+    }
+}
+
+// Steps through job's command trees until a pipeline is running or the job is
+// finished
+static void advance(eggJob* job)
+{
+    while(job->pid < 0 && !job->done)
+    {
+        if(job->andOr) // run the next pipeline of the <and-or>
+        {
+            CMD* node = job->andOr;
+            bool isAndOr = (node->type == SEP_AND || node->type == SEP_OR);
+            startPipeline(job, isAndOr ? node->left : node);
+        }
+        else if(job->rest) // move on to the next <and-or> of the line
+        {
+            CMD* node = job->rest;
+            if(node->type == SEP_BG)
+            {
+                if(isContextBuiltin(node->left))
+                {
+                    runBuiltin(job->ctx, node->left);
+                }
+                else
+                {
+                    startBackground(job->ctx, node->left);
+                }
+                job->status = 0;
+                job->rest = node->right;
+            }
+            else if(node->type == SEP_END)
+            {
+                job->andOr = node->left;
+                job->rest = node->right;
+            }
+            else
+            {
+                job->andOr = node;
+                job->rest = NULL;
+            }
+        }
+        else if(job->line < job->script->nCmds) // move on to the next line
+        {
+            job->rest = job->script->cmds[job->line++];
+        }
+        else
+        {
+            job->done = true;
+            if(job->callback)
+            {
+                job->callback(job, job->status, job->arg);
+            }
+        }
+    }
+}
+
+eggJob* eggStart(eggContext* ctx, const eggScript* script, eggCallback done,
+                 void* arg)
+{
+    eggJob* job = malloc(sizeof(eggJob));
+    if(!job)
+    {
+        return NULL;
+    }
+    if((job->epollFd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+    {
+        free(job);
+        return NULL;
+    }
+
+    job->ctx = ctx;
+    job->script = script;
+    job->line = 0;
+    job->rest = NULL;
+    job->andOr = NULL;
+    job->pid = -1;
+    job->pidFd = -1;
+    job->status = 0;
+    job->done = false;
+    job->callback = done;
+    job->arg = arg;
+
+    advance(job);
+    return job;
+}
+
+int eggJobFd(const eggJob* job)
+{
+    return job->epollFd;
+}
+
+bool eggPoll(eggJob* job, int* status)
+{
+    if(job->pid > 0)
+    {
+        int wstatus;
+        pid_t pid = waitpid(job->pid, &wstatus, WNOHANG);
+        if(pid == job->pid || (pid < 0 && errno != EINTR))
+        {
+            int pipelineStatus = (pid < 0) ? errno : GET_STATUS(wstatus);
+            epoll_ctl(job->epollFd, EPOLL_CTL_DEL, job->pidFd, NULL);
+            close(job->pidFd);
+            job->pid = -1;
+            finishPipeline(job, pipelineStatus);
+            advance(job);
+        }
+    }
+
+    if(job->done && status)
+    {
+        *status = job->status;
+    }
+    return job->done;
+}
+
+void eggFreeJob(eggJob* job)
+{
+    if(job)
+    {
+        close(job->epollFd);
+        free(job);
+    }
+}
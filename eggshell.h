@@ -0,0 +1,101 @@
+/*
+ * File:   eggshell.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for libeggshell, which embeds the shell's tokenizer, parser, and
+ * executor in a host process so that it can run scripts without starting a
+ * shell for each one.
+ *
+ * Each eggContext holds the state a shell would: its variables, working
+ * directory, directory stack, input mode, and standard input, output, and
+ * error. A script is parsed once with eggParse() and can then be run any
+ * number of times with eggRun(), in any context.
+ *
+ * None of a context's state is swapped into the host: commands run in
+ * children of the host that take on the context's descriptors, working
+ * directory, and environment, and the built-ins that change the shell (cd,
+ * pushd, popd, setenv, and unsetenv) change the context instead, writing to
+ * its descriptors. So different contexts can be used from different threads
+ * at once, though each context by only one thread at a time; eggParse() holds
+ * a lock while it works, since the parser's state is global. A run waits only
+ * for the children it starts, each through its pidfd, so the host must not
+ * wait for children it didn't start itself (e.g., with wait() or
+ * waitpid(-1, ...)), which would take their exit statuses.
+ */
+
+#ifndef EGGSHELL_H
+#define EGGSHELL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// the library is built with its symbols hidden, except these functions
+#define EGG_API __attribute__((visibility("default")))
+
+typedef struct eggContext eggContext;
+typedef struct eggScript eggScript;
+
+// Returns a new context whose standard input, output, and error are in, out,
+// and err, which remain the caller's to close. It starts in the process's
+// working directory, with a copy of its environment, and reads white-space
+// input. Returns NULL on failure.
+EGG_API eggContext* eggNewContext(int in, int out, int err);
+
+// Frees ctx
+EGG_API void eggFreeContext(eggContext* ctx);
+
+// Makes ctx parse white-space input (normal == 0) or plain text (normal != 0)
+EGG_API void eggSetNormalInput(eggContext* ctx, int normal);
+
+// Sets ctx's variable name to value, or removes it if value is NULL
+EGG_API void eggSetVar(eggContext* ctx, const char* name, const char* value);
+
+// Returns the value of ctx's variable name, or NULL if it is not set
+EGG_API const char* eggGetVar(eggContext* ctx, const char* name);
+
+// Parses the len chars of script at buf, encoded in ctx's input mode, with
+// ctx's variables expanded in its here documents. Syntax errors are reported
+// on ctx's standard error. Returns the parsed script, or NULL if it has a
+// syntax error.
+EGG_API eggScript* eggParse(eggContext* ctx, const char* buf, size_t len);
+
+// Runs script in ctx and returns the status of its last command, as the shell
+// would; $?, the working directory, and the directory stack carry over to the
+// next run in ctx
+EGG_API int eggRun(eggContext* ctx, const eggScript* script);
+
+// Frees script
+EGG_API void eggFreeScript(eggScript* script);
+
+// A script started by eggStart() runs as a state machine: each pipeline is
+// forked off, and the &&, ||, and ; that follow it are acted on when it exits,
+// so a single thread can drive many jobs at once. Built-ins that change the
+// shell run immediately in the context when on their own; elsewhere (e.g., in
+// a pipeline) they run in a child and don't affect it.
+typedef struct eggJob eggJob;
+
+// Called with a job, its status, and the arg given to eggStart() when the job
+// finishes
+typedef void (*eggCallback)(eggJob* job, int status, void* arg);
+
+// Starts running script in ctx, which must outlive the job, without waiting
+// for it. done, if not NULL, is called with arg when the job finishes, which
+// may be before eggStart() returns. Returns the job, or NULL on failure.
+EGG_API eggJob* eggStart(eggContext* ctx, const eggScript* script,
+                         eggCallback done, void* arg);
+
+// Returns a descriptor that becomes readable when job has progress to make,
+// for poll() or epoll; eggPoll() should then be called
+EGG_API int eggJobFd(const eggJob* job);
+
+// Makes whatever progress job can without blocking. Returns true and sets
+// *status (if status isn't NULL) to the status of its last command if it has
+// finished, or false otherwise.
+EGG_API bool eggPoll(eggJob* job, int* status);
+
+// Frees job, which must have finished
+EGG_API void eggFreeJob(eggJob* job);
+
+#endif
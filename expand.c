@@ -0,0 +1,867 @@
+/*
+ * File:   expand.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the argument expansion described in expand.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include "expand.h"
+#include "process.h"
+#include "cacheDir.h"
+#include "dirCache.h"
+
+#define MEM_SUBSYSTEM MEM_PROCESS
+#include "memStats.h"
+
+// the environment variable limiting the output of a command substitution, and
+// its default
+#define SUBST_MAX_VAR "EGGSHELL_SUBST_MAX"
+#define SUBST_MAX_DEFAULT (64ULL << 20)
+
+// the output buffer starts at this size and grows by this factor; reads fill
+// whatever room is left in it
+#define OUTPUT_INIT_SIZE (64 * 1024)
+#define OUTPUT_GROWTH_FACTOR (2)
+
+#define ARGV_INIT_SIZE (8)
+#define BLOCKS_INIT_SIZE (4)
+#define LIST_GROWTH_FACTOR (2)
+
+#define WORD_INIT_SIZE (64)
+#define WORD_GROWTH_FACTOR (2)
+
+// the ops of a compiled glob pattern
+enum {
+    OP_CHAR,  // a literal char
+    OP_ANY,   // ?
+    OP_STAR,  // *
+    OP_CLASS  // [...]
+};
+
+typedef struct
+{
+    int type;
+    char c;                // the char of an OP_CHAR
+    unsigned char set[32]; // the chars an OP_CLASS matches, a bit each
+} patternOp;
+
+// a path component of a glob, compiled once and matched against every name in
+// a directory
+typedef struct
+{
+    patternOp* ops;
+    int nOps;
+    bool wild;       // does it have any *, ?, or [...]?
+    char* text;      // its text without marks, for when it doesn't
+    char suffix[16]; // the literal chars after its last *, if that's all that
+    size_t suffixLen; //   follows it
+} pattern;
+
+// the argument being built from literal text and output
+typedef struct
+{
+    char* text;   // malloc'd text, or NULL if none has been copied yet
+    size_t len, size;
+    char* piece;  // uncopied output that the argument consists of so far, or
+                  //   NULL
+    bool started; // has anything (even an empty quoted output) been added?
+} word;
+
+// Returns an empty argList
+static argList* newArgList(void)
+{
+    argList* args = malloc(sizeof(argList));
+    args->argc = 0;
+    args->argvSize = ARGV_INIT_SIZE;
+    args->argv = malloc(sizeof(char*) * args->argvSize);
+    args->argv[0] = NULL;
+    args->nBlocks = 0;
+    args->blocksSize = BLOCKS_INIT_SIZE;
+    args->blocks = malloc(sizeof(char*) * args->blocksSize);
+    return args;
+}
+
+// Adds arg to the end of args
+static void addArg(argList* args, char* arg)
+{
+    if(args->argc + 1 >= args->argvSize)
+    {
+        args->argvSize *= LIST_GROWTH_FACTOR;
+        args->argv = realloc(args->argv, sizeof(char*) * args->argvSize);
+    }
+    args->argv[args->argc++] = arg;
+    args->argv[args->argc] = NULL;
+}
+
+// Makes args responsible for freeing block
+static void addBlock(argList* args, char* block)
+{
+    if(args->nBlocks == args->blocksSize)
+    {
+        args->blocksSize *= LIST_GROWTH_FACTOR;
+        args->blocks = realloc(args->blocks,
+                               sizeof(char*) * args->blocksSize);
+    }
+    args->blocks[args->nBlocks++] = block;
+}
+
+// Appends the len chars at s to w, copying its piece of output first if it
+// has one
+static void appendWord(word* w, const char* s, size_t len)
+{
+    if(w->piece)
+    {
+        const char* piece = w->piece;
+        w->piece = NULL;
+        appendWord(w, piece, strlen(piece));
+    }
+
+    if(!w->text || w->len + len + 1 > w->size)
+    {
+        size_t size = w->text ? w->size : WORD_INIT_SIZE;
+        while(w->len + len + 1 > size)
+        {
+            size *= WORD_GROWTH_FACTOR;
+        }
+        w->text = realloc(w->text, size);
+        w->size = size;
+    }
+    memcpy(w->text + w->len, s, len);
+    w->len += len;
+    w->text[w->len] = '\0';
+    w->started = true;
+}
+
+// Adds w to args, if anything was added to it, and empties it
+static void endWord(argList* args, word* w)
+{
+    if(w->text)
+    {
+        addBlock(args, w->text);
+        addArg(args, w->text);
+    }
+    else if(w->piece)
+    {
+        addArg(args, w->piece); // points into the output
+    }
+    else if(w->started)
+    {
+        addArg(args, ""); // an empty quoted output
+    }
+    memset(w, 0, sizeof(word));
+}
+
+// Runs the command line text in a subshell and returns its output in a
+// malloc'd, null-terminated buffer, setting *len to its length. Returns NULL,
+// having printed an error, if the command can't be run or its output is
+// longer than $EGGSHELL_SUBST_MAX.
+static char* capture(char* text, size_t* len)
+{
+    unsigned long long max = envNumber(SUBST_MAX_VAR, SUBST_MAX_DEFAULT);
+    int fd[2], pid;
+
+    if(pipe(fd) < 0 || (pid = fork()) < 0)
+    {
+        perror(EXEC_NAME);
+        return NULL;
+    }
+    else if(pid == 0)
+    {
+        // child; a syntax error is the subshell's to report
+        close(fd[0]);
+        dup2(fd[1], STDOUT_FILENO);
+        close(fd[1]);
+        setParseErrorHandler(NULL);
+
+        token* list = tokenize(text);
+        CMD* cmd = list ? parse(list) : NULL;
+        exit(cmd ? process(cmd) : EXIT_FAILURE);
+    }
+
+    close(fd[1]);
+    size_t size = (OUTPUT_INIT_SIZE < max + 2) ? OUTPUT_INIT_SIZE : max + 2;
+    size_t n = 0;
+    char* buf = malloc(size);
+    bool tooLong = false;
+    ssize_t got = 0;
+
+    // read into whatever room is left, growing the buffer when it fills up,
+    // but never past room for one byte more than is allowed
+    for( ; ; )
+    {
+        if(n + 1 == size)
+        {
+            size = (size * OUTPUT_GROWTH_FACTOR < max + 2) ?
+                   size * OUTPUT_GROWTH_FACTOR : max + 2;
+            buf = realloc(buf, size);
+        }
+        if((got = read(fd[0], buf + n, size - n - 1)) == 0)
+        {
+            break;
+        }
+        else if(got < 0 && errno != EINTR)
+        {
+            perror(EXEC_NAME);
+            break;
+        }
+        n += (got > 0) ? got : 0;
+        if(n > max)
+        {
+            tooLong = true;
+            break;
+        }
+    }
+
+    // a producer that is cut off gets a broken pipe
+    close(fd[0]);
+    if(tooLong || got < 0)
+    {
+        kill(pid, SIGTERM);
+    }
+    signal(SIGINT, SIG_IGN);
+    while(waitpid(pid, NULL, 0) < 0 && errno == EINTR);
+    signal(SIGINT, SIG_DFL);
+
+    if(tooLong)
+    {
+        fprintf(stderr, "%s: Output of `%s` exceeds %s (%llu bytes)\n",
+                EXEC_NAME, text, SUBST_MAX_VAR, max);
+    }
+    if(tooLong || got < 0)
+    {
+        free(buf);
+        return NULL;
+    }
+
+    buf[n] = '\0';
+    *len = n;
+    return buf;
+}
+
+// Adds the output out, of length len and without its trailing newlines, to w
+// and args: as part of w if quoted, and split into words otherwise, the first
+// of which continues w and the last of which is left in w for the rest of the
+// argument to continue
+static void addOutput(argList* args, word* w, char* out, size_t len,
+                      bool quoted)
+{
+    while(len > 0 && out[len - 1] == '\n')
+    {
+        len--;
+    }
+    if(quoted)
+    {
+        appendWord(w, out, len);
+        return;
+    }
+
+    char* p = out;
+    char* end = out + len;
+    while(p < end)
+    {
+        if(isspace((unsigned char)*p))
+        {
+            endWord(args, w);
+            while(p < end && isspace((unsigned char)*p))
+            {
+                p++;
+            }
+            continue;
+        }
+
+        // terminate the word in place
+        char* start = p;
+        while(p < end && !isspace((unsigned char)*p))
+        {
+            p++;
+        }
+        bool atEnd = (p == end);
+        *p = '\0';
+
+        if(w->started)
+        {
+            appendWord(w, start, p - start);
+        }
+        else
+        {
+            w->piece = start;
+            w->started = true;
+        }
+        if(!atEnd)
+        {
+            p++;
+            endWord(args, w);
+            while(p < end && isspace((unsigned char)*p))
+            {
+                p++;
+            }
+        }
+    }
+}
+
+// Adds the words that arg's command substitutions expand it to to args.
+// Returns false if a substitution fails.
+static bool substituteArg(argList* args, char* arg)
+{
+    word w;
+    memset(&w, 0, sizeof(w));
+
+    char* p = arg;
+    while(*p)
+    {
+        size_t literal = strcspn(p, SUBST_MARKS);
+        if(literal > 0)
+        {
+            appendWord(&w, p, literal);
+            p += literal;
+            continue;
+        }
+
+        char mark = *p++;
+        char* close = strchr(p, mark);
+        size_t cmdLen = close ? (size_t)(close - p) : strlen(p);
+        char command[cmdLen + 1];
+        memcpy(command, p, cmdLen);
+        command[cmdLen] = '\0';
+        p += cmdLen + (close ? 1 : 0);
+
+        size_t len;
+        char* out = capture(command, &len);
+        if(!out)
+        {
+            free(w.text);
+            return false;
+        }
+        addBlock(args, out);
+        addOutput(args, &w, out, len, mark == SUBST_QUOTED);
+    }
+    endWord(args, &w);
+    return true;
+}
+
+// Returns true if the byte c is in the set of a CLASS op
+#define IN_SET(set, c) ((set)[(unsigned char)(c) / 8] & \
+                        (1 << ((unsigned char)(c) % 8)))
+
+// Compiles the bracket expression (a [ has been read) at the start of the len
+// chars at s into op. Returns the number of chars it takes up, through the
+// closing ], or 0 if there isn't one.
+static size_t compileClass(const char* s, size_t len, patternOp* op)
+{
+    size_t i = 0;
+    bool negate = false;
+    memset(op->set, 0, sizeof(op->set));
+    op->type = OP_CLASS;
+
+    if(i < len && (s[i] == '!' || s[i] == '^'))
+    {
+        negate = true;
+        i++;
+    }
+    for(bool first = true; i < len; first = false)
+    {
+        if(s[i] == GLOB_MARK)
+        {
+            i++;
+            continue;
+        }
+        if(s[i] == ']' && !first)
+        {
+            if(negate)
+            {
+                for(size_t j = 0; j < sizeof(op->set); j++)
+                {
+                    op->set[j] = ~op->set[j];
+                }
+            }
+            return i + 1;
+        }
+
+        unsigned char lo = s[i++], hi = lo;
+        if(i + 1 < len && s[i] == '-' && s[i + 1] != ']')
+        {
+            hi = s[i + 1];
+            i += 2;
+        }
+        for(int c = lo; c <= hi; c++)
+        {
+            op->set[c / 8] |= 1 << (c % 8);
+        }
+    }
+    return 0;
+}
+
+// Compiles the path component made up of the len chars at s into pat. The
+// component's text, without its marks, is left in pat->text.
+static void compilePattern(const char* s, size_t len, pattern* pat)
+{
+    patternOp* ops = malloc(sizeof(patternOp) * (len + 1));
+    int n = 0, lastStar = -1;
+
+    pat->text = malloc(len + 1);
+    size_t textLen = 0;
+    pat->wild = false;
+    for(size_t i = 0; i < len; )
+    {
+        if(s[i] == GLOB_MARK && i + 1 < len)
+        {
+            char c = s[i + 1];
+            size_t classLen;
+            if(c == '*')
+            {
+                if(n == 0 || ops[n - 1].type != OP_STAR)
+                {
+                    lastStar = n;
+                    ops[n++].type = OP_STAR;
+                }
+                pat->wild = true;
+                i += 2;
+                continue;
+            }
+            else if(c == '?')
+            {
+                ops[n++].type = OP_ANY;
+                pat->wild = true;
+                i += 2;
+                continue;
+            }
+            else if(c == '[' &&
+                    (classLen = compileClass(s + i + 2, len - i - 2, &ops[n])))
+            {
+                n++;
+                pat->wild = true;
+                i += 2 + classLen;
+                continue;
+            }
+        }
+        if(s[i] == GLOB_MARK)
+        {
+            i++; // an unmatched [ or a { that's literal
+            continue;
+        }
+        ops[n].type = OP_CHAR;
+        ops[n++].c = s[i];
+        pat->text[textLen++] = s[i++];
+    }
+    pat->text[textLen] = '\0';
+    pat->ops = ops;
+    pat->nOps = n;
+
+    // the literal chars after the last * rule out most names at once
+    pat->suffixLen = 0;
+    if(lastStar >= 0 && n - lastStar - 1 <= (int)sizeof(pat->suffix))
+    {
+        int i = lastStar + 1;
+        while(i < n && ops[i].type == OP_CHAR)
+        {
+            i++;
+        }
+        for(int j = lastStar + 1; i == n && j < n; j++)
+        {
+            pat->suffix[pat->suffixLen++] = ops[j].c;
+        }
+    }
+}
+
+static void freePattern(pattern* pat)
+{
+    free(pat->ops);
+    free(pat->text);
+}
+
+// Returns true if op matches the char c
+static bool matchOp(const patternOp* op, char c)
+{
+    switch(op->type)
+    {
+        case OP_CHAR:
+            return op->c == c;
+        case OP_ANY:
+            return true;
+        default:
+            return IN_SET(op->set, c);
+    }
+}
+
+// Returns true if pat matches all of name. A name starting with . is only
+// matched by a pattern that starts with one.
+static bool matchPattern(const pattern* pat, const char* name)
+{
+    const patternOp* ops = pat->ops;
+    int n = pat->nOps;
+
+    if(name[0] == '.' && (n == 0 || ops[0].type != OP_CHAR || ops[0].c != '.'))
+    {
+        return false;
+    }
+    if(pat->suffixLen > 0)
+    {
+        size_t len = strlen(name);
+        if(len < pat->suffixLen ||
+           memcmp(name + len - pat->suffixLen, pat->suffix, pat->suffixLen))
+        {
+            return false;
+        }
+    }
+
+    // on a mismatch, the last * takes one more char and matching resumes
+    int op = 0, starOp = -1;
+    const char* s = name;
+    const char* starS = NULL;
+    while(*s)
+    {
+        if(op < n && ops[op].type == OP_STAR)
+        {
+            starOp = op++;
+            starS = s;
+        }
+        else if(op < n && matchOp(&ops[op], *s))
+        {
+            op++;
+            s++;
+        }
+        else if(starOp >= 0)
+        {
+            op = starOp + 1;
+            s = ++starS;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while(op < n && ops[op].type == OP_STAR)
+    {
+        op++;
+    }
+    return op == n;
+}
+
+// Adds the paths that match pat, a word's components from some point on, to
+// args; prefix, of length len, is the path of the directory they are in ("" for
+// the working directory), ending in / if it isn't empty
+static void globFrom(argList* args, const char* prefix, size_t len,
+                     const char* pat)
+{
+    const char* slash = strchr(pat, '/');
+    size_t compLen = slash ? (size_t)(slash - pat) : strlen(pat);
+    const char* rest = pat + compLen;
+    while(*rest == '/')
+    {
+        rest++;
+    }
+
+    pattern comp;
+    compilePattern(pat, compLen, &comp);
+
+    if(!comp.wild)
+    {
+        // a literal component (and any slashes after it) needs no listing
+        size_t textLen = strlen(comp.text), slashes = rest - pat - compLen;
+        char* path = malloc(len + textLen + slashes + 1);
+        memcpy(path, prefix, len);
+        memcpy(path + len, comp.text, textLen);
+        memset(path + len + textLen, '/', slashes);
+        path[len + textLen + slashes] = '\0';
+        freePattern(&comp);
+
+        struct stat st;
+        if(slash && *rest)
+        {
+            globFrom(args, path, len + textLen + slashes, rest);
+            free(path);
+        }
+        else if(lstat(path, &st) == 0)
+        {
+            addBlock(args, path);
+            addArg(args, path);
+        }
+        else
+        {
+            free(path);
+        }
+        return;
+    }
+
+    dirListing* listing = openListing(len ? prefix : ".");
+    for(int i = 0; listing && i < listing->nNames; i++)
+    {
+        const char* name = listing->names[i];
+        unsigned char type = listing->types[i];
+        if((slash && type != DT_DIR && type != DT_LNK && type != DT_UNKNOWN) ||
+           !matchPattern(&comp, name))
+        {
+            continue;
+        }
+
+        size_t nameLen = strlen(name);
+        char* path = malloc(len + nameLen + 2);
+        memcpy(path, prefix, len);
+        memcpy(path + len, name, nameLen + 1);
+        if(!slash)
+        {
+            addBlock(args, path);
+            addArg(args, path);
+        }
+        else if(!*rest)
+        {
+            // a trailing / matches only directories
+            struct stat st;
+            strcpy(path + len + nameLen, "/");
+            if(stat(path, &st) == 0 && S_ISDIR(st.st_mode))
+            {
+                addBlock(args, path);
+                addArg(args, path);
+            }
+            else
+            {
+                free(path);
+            }
+        }
+        else
+        {
+            strcpy(path + len + nameLen, "/");
+            globFrom(args, path, len + nameLen + 1, rest);
+            free(path);
+        }
+    }
+    if(listing)
+    {
+        releaseListing(listing);
+    }
+    freePattern(&comp);
+}
+
+// Returns true if word has a *, ?, or [...] that can match file names
+static bool isWild(const char* word)
+{
+    while(*word)
+    {
+        size_t len = strcspn(word, "/");
+        pattern comp;
+        compilePattern(word, len, &comp);
+        bool wild = comp.wild;
+        freePattern(&comp);
+        if(wild)
+        {
+            return true;
+        }
+        word += len + (word[len] == '/');
+    }
+    return false;
+}
+
+// Adds word to args, which hold its storage, without its marks
+static void addLiteral(argList* args, const char* word)
+{
+    char* text = malloc(strlen(word) + 1);
+    char* q = text;
+    for(const char* p = word; *p; p++)
+    {
+        if(*p != GLOB_MARK)
+        {
+            *q++ = *p;
+        }
+    }
+    *q = '\0';
+    addBlock(args, text);
+    addArg(args, text);
+}
+
+// Adds the words that the first {...} in word expands to, with the rest of
+// their braces expanded in turn, to words, whose storage args holds. A { with
+// no matching }, or {}, is literal.
+static void expandBraces(argList* args, argList* words, const char* word)
+{
+    const char* open = word;
+    while((open = strchr(open, GLOB_MARK)) && open[1] != '{')
+    {
+        open++;
+    }
+    if(!open)
+    {
+        char* copy = malloc(strlen(word) + 1);
+        strcpy(copy, word);
+        addBlock(args, copy);
+        addArg(words, copy);
+        return;
+    }
+
+    // find the matching } and the commas between
+    const char* body = open + 2;
+    const char* close = NULL;
+    int depth = 1;
+    for(const char* p = body; *p && !close; p++)
+    {
+        if(*p == GLOB_MARK && p[1] == '{')
+        {
+            depth++;
+            p++;
+        }
+        else if(*p == '}' && --depth == 0)
+        {
+            close = p;
+        }
+    }
+
+    size_t prefixLen = open - word;
+    if(!close || close == body)
+    {
+        // keep the { as it is, and carry on after it
+        size_t len = strlen(word);
+        char literal[len];
+        memcpy(literal, word, prefixLen);
+        strcpy(literal + prefixLen, open + 1);
+        expandBraces(args, words, literal);
+        return;
+    }
+
+    size_t suffixLen = strlen(close + 1);
+    const char* alt = body;
+    depth = 0;
+    for(const char* p = body; p <= close; p++)
+    {
+        if(*p == GLOB_MARK && p[1] == '{')
+        {
+            depth++;
+            p++;
+            continue;
+        }
+        else if(*p == '}' && p != close)
+        {
+            depth--;
+            continue;
+        }
+        else if(p != close && (*p != ',' || depth > 0))
+        {
+            continue;
+        }
+
+        // alt up to p is one alternative
+        size_t altLen = p - alt;
+        char next[prefixLen + altLen + suffixLen + 1];
+        memcpy(next, word, prefixLen);
+        memcpy(next + prefixLen, alt, altLen);
+        strcpy(next + prefixLen + altLen, close + 1);
+        expandBraces(args, words, next);
+        alt = p + 1;
+    }
+}
+
+// Orders strings for qsort()
+static int compareStrings(const void* a, const void* b)
+{
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Adds the words that word's braces and globs expand to to args. Returns
+// false, having printed an error, if a glob matches nothing and $nonomatch
+// isn't set (if it is, the glob is kept as it is).
+static bool globWord(argList* args, const char* word)
+{
+    argList* words = newArgList();
+    bool ok = true;
+
+    expandBraces(args, words, word);
+    for(int i = 0; i < words->argc; i++)
+    {
+        const char* w = words->argv[i];
+        int start = args->argc;
+        if(isWild(w))
+        {
+            globFrom(args, "", 0, w);
+        }
+
+        if(args->argc > start)
+        {
+            qsort(args->argv + start, args->argc - start, sizeof(char*),
+                  compareStrings);
+        }
+        else if(!isWild(w) || getenv("nonomatch"))
+        {
+            addLiteral(args, w);
+        }
+        else
+        {
+            fprintf(stderr, "%s: No match.\n", EXEC_NAME);
+            ok = false;
+            break;
+        }
+    }
+
+    free(words->argv);
+    free(words->blocks);
+    free(words);
+    return ok;
+}
+
+argList* expandArgs(char** argv)
+{
+    argList* args = newArgList();
+
+    for( ; *argv; argv++)
+    {
+        bool substituted = strpbrk(*argv, SUBST_MARKS);
+        bool globbed = strchr(*argv, GLOB_MARK);
+        int start = args->argc;
+
+        if(!substituted && !globbed)
+        {
+            addArg(args, *argv); // nothing to expand
+            continue;
+        }
+        else if(substituted && !substituteArg(args, *argv))
+        {
+            freeArgList(args);
+            return NULL;
+        }
+        else if(!substituted)
+        {
+            addArg(args, *argv);
+        }
+
+        if(globbed)
+        {
+            // glob the words made from the argument in place of them
+            int n = args->argc - start;
+            char* words[n];
+            memcpy(words, args->argv + start, sizeof(char*) * n);
+            args->argc = start;
+            args->argv[start] = NULL;
+            for(int i = 0; i < n; i++)
+            {
+                if(!globWord(args, words[i]))
+                {
+                    freeArgList(args);
+                    return NULL;
+                }
+            }
+        }
+    }
+    return args;
+}
+
+void freeArgList(argList* args)
+{
+    for(int i = 0; i < args->nBlocks; i++)
+    {
+        free(args->blocks[i]);
+    }
+    free(args->blocks);
+    free(args->argv);
+    free(args);
+}
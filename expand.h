@@ -0,0 +1,42 @@
+/*
+ * File:   expand.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for expanding the arguments of a <simple> when it is executed,
+ * replacing each command substitution `<command>` with the command's output.
+ *
+ * The output is read straight into a buffer that grows as needed, with large
+ * reads, and is split into words in place, so an argument made of a single
+ * word of output points into the buffer rather than at a copy. The output may
+ * be at most $EGGSHELL_SUBST_MAX bytes (a number with an optional K, M, or G
+ * suffix; 64M by default), so a runaway command can't exhaust the shell's
+ * memory.
+ */
+
+#ifndef EXPAND_H
+#define EXPAND_H
+
+typedef struct
+{
+    int argc;      // the number of arguments
+    char** argv;   // the null-terminated arguments
+    int argvSize;  // malloc'd size of argv
+
+    char** blocks; // malloc'd storage that the arguments point into
+    int nBlocks;   // the number of blocks
+    int blocksSize; // malloc'd size of blocks
+} argList;
+
+// Returns the arguments argv of a <simple> with their command substitutions
+// replaced by the output of the commands, which are run in subshells. Returns
+// NULL, having printed an error, if a command can't be run or its output is
+// too large.
+argList* expandArgs(char** argv);
+
+// Frees args and its storage; arguments that needed no expansion point into
+// the caller's argv and are left alone
+void freeArgList(argList* args);
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * File:   fdCache.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the cache of files open for appending described in
+ * fdCache.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "fdCache.h"
+
+#define MEM_SUBSYSTEM MEM_PROCESS
+#include "memStats.h"
+
+// the number of files kept open
+#define CACHE_ENTRIES (8)
+
+// cached descriptors are moved at least this high, out of the way of the
+// standard ones that commands are redirected onto
+#define MIN_CACHED_FD (10)
+
+typedef struct
+{
+    char* path;              // the path appended to; NULL if unused
+    dev_t dev;               //   and the file it named
+    ino_t ino;
+    int fd;                  // open on the file for appending
+    unsigned long hits;      // the times it was reused
+    unsigned long lastUse;   // useClock when it was last returned
+} fdEntry;
+
+static fdEntry cache[CACHE_ENTRIES];
+static unsigned long useClock = 0;
+
+// Closes entry and marks it unused
+static void dropEntry(fdEntry* entry)
+{
+    close(entry->fd);
+    free(entry->path);
+    entry->path = NULL;
+}
+
+// Returns the entry for path if it still appends to the file st that path
+// names, or NULL; a stale entry is dropped
+static fdEntry* findEntry(const char* path, const struct stat* st)
+{
+    for(int i = 0; i < CACHE_ENTRIES; i++)
+    {
+        if(cache[i].path && strcmp(cache[i].path, path) == 0)
+        {
+            struct stat fdSt;
+            if(st && st->st_dev == cache[i].dev && st->st_ino == cache[i].ino &&
+               fstat(cache[i].fd, &fdSt) == 0 && fdSt.st_dev == cache[i].dev &&
+               fdSt.st_ino == cache[i].ino)
+            {
+                cache[i].hits++;
+                cache[i].lastUse = ++useClock;
+                return &cache[i];
+            }
+            dropEntry(&cache[i]);
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+// Caches fd, open on the regular file st for appending to path, if it can.
+// Returns the descriptor to use, setting *cached if it's the cache's.
+static int addEntry(const char* path, int fd, const struct stat* st,
+                    bool* cached)
+{
+    int high = fcntl(fd, F_DUPFD_CLOEXEC, MIN_CACHED_FD);
+    if(high < 0)
+    {
+        return fd;
+    }
+    close(fd);
+
+    fdEntry* lru = &cache[0];
+    for(int i = 0; i < CACHE_ENTRIES && lru->path; i++)
+    {
+        if(!cache[i].path || cache[i].lastUse < lru->lastUse)
+        {
+            lru = &cache[i];
+        }
+    }
+    if(lru->path)
+    {
+        dropEntry(lru);
+    }
+
+    lru->path = strdup(path);
+    lru->dev = st->st_dev;
+    lru->ino = st->st_ino;
+    lru->fd = high;
+    lru->hits = 0;
+    lru->lastUse = ++useClock;
+    *cached = true;
+    return high;
+}
+
+int appendFd(const char* path, bool create, bool* cached)
+{
+    struct stat st;
+    fdEntry* entry = findEntry(path, (stat(path, &st) == 0) ? &st : NULL);
+    if((*cached = (entry != NULL)))
+    {
+        return entry->fd;
+    }
+
+    int flags = O_WRONLY | O_APPEND | O_CLOEXEC | (create ? O_CREAT : 0);
+    int fd = open(path, flags, (mode_t)0666);
+    if(fd < 0 || fstat(fd, &st) < 0 || !S_ISREG(st.st_mode))
+    {
+        // pipes, terminals, and devices aren't held open
+        return fd;
+    }
+    return addEntry(path, fd, &st, cached);
+}
+
+int cachedAppendFd(const char* path)
+{
+    struct stat st;
+    if(stat(path, &st) < 0 || !S_ISREG(st.st_mode))
+    {
+        return -1;
+    }
+    fdEntry* entry = findEntry(path, &st);
+    if(entry)
+    {
+        return entry->fd;
+    }
+
+    int fd = open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return -1;
+    }
+    bool cached = false;
+    if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    {
+        fd = addEntry(path, fd, &st, &cached);
+    }
+    if(!cached)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void dumpFdCache(int fd)
+{
+    for(int i = 0; i < CACHE_ENTRIES; i++)
+    {
+        if(cache[i].path)
+        {
+            dprintf(fd, "%s: %lu reuses\n", cache[i].path, cache[i].hits);
+        }
+    }
+}
+
+void closeFdCache(void)
+{
+    for(int i = 0; i < CACHE_ENTRIES; i++)
+    {
+        if(cache[i].path)
+        {
+            dropEntry(&cache[i]);
+        }
+    }
+}
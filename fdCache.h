@@ -0,0 +1,41 @@
+/*
+ * File:   fdCache.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for the cache of files open for appending, which spares a loop of
+ * `cmd >> log` from opening and closing log each time. The shell keeps the
+ * last few regular files it appended to open, keyed by path, device, and
+ * inode, and hands the descriptors to the commands that append to them, which
+ * get them with dup2(). An entry is only reused if the path still names the
+ * file it has open, as stat() and fstat() tell, so a log that is removed or
+ * rotated is opened afresh. The fdcache built-in lists and closes the entries.
+ */
+
+#ifndef FDCACHE_H
+#define FDCACHE_H
+
+#include <stdbool.h>
+
+// Returns a descriptor open for appending to path: the cached one, if path
+// still names the file it has open, or else a new one, creating the file if
+// create is true, which is cached if the file is regular. Sets *cached if the
+// descriptor belongs to the cache, in which case it is close-on-exec and
+// mustn't be closed. Returns -1 with errno set if path can't be opened.
+int appendFd(const char* path, bool create, bool* cached);
+
+// Returns the cached descriptor for appending to path, for a child about to be
+// forked to use, caching one first if path names a regular file. Returns -1,
+// leaving the file for the child to open as usual, if path names anything else
+// or can't be opened, so that the shell never blocks opening a FIFO.
+int cachedAppendFd(const char* path);
+
+// Prints the paths of the cached files, and how many times each was reused, to
+// fd
+void dumpFdCache(int fd);
+
+// Closes the cached files and empties the cache
+void closeFdCache(void);
+
+#endif
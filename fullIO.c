@@ -0,0 +1,57 @@
+/*
+ * File:   fullIO.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the whole-buffer reads and writes described in fullIO.h
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "fullIO.h"
+
+bool writeAll(int fd, const void* buf, size_t len)
+{
+    for(size_t done = 0; done < len; )
+    {
+        ssize_t n = write(fd, (const char*)buf + done, len - done);
+        if(n < 0 && errno != EINTR)
+        {
+            return false;
+        }
+        done += (n > 0) ? n : 0;
+    }
+    return true;
+}
+
+bool sendAll(int fd, const void* buf, size_t len)
+{
+    for(size_t done = 0; done < len; )
+    {
+        ssize_t n = send(fd, (const char*)buf + done, len - done,
+                         MSG_NOSIGNAL);
+        if(n < 0 && errno != EINTR)
+        {
+            return false;
+        }
+        done += (n > 0) ? n : 0;
+    }
+    return true;
+}
+
+bool readAll(int fd, void* buf, size_t len)
+{
+    for(size_t done = 0; done < len; )
+    {
+        ssize_t n = read(fd, (char*)buf + done, len - done);
+        if(n == 0 || (n < 0 && errno != EINTR))
+        {
+            return false;
+        }
+        done += (n > 0) ? n : 0;
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+/*
+ * File:   fullIO.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for reading and writing whole buffers on a descriptor, retrying
+ * after short transfers and interrupted calls.
+ */
+
+#ifndef FULLIO_H
+#define FULLIO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Writes the len bytes at buf to fd. Returns true if successful, or false
+// with errno set.
+bool writeAll(int fd, const void* buf, size_t len);
+
+// Writes the len bytes at buf to the socket fd, without raising SIGPIPE if the
+// other end is gone. Returns true if successful, or false with errno set.
+bool sendAll(int fd, const void* buf, size_t len);
+
+// Reads exactly len bytes from fd into buf. Returns true if successful, or
+// false on error (with errno set) or at end of file.
+bool readAll(int fd, void* buf, size_t len);
+
+#endif
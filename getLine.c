@@ -2,6 +2,7 @@
  * File:   getLine.c
  * Original Author: Stan Eisenstat
  * Modified By: Alexander Schurman (alexander.schurman@gmail.com)
+ * Modified By: agent (agent@local)
  *
  * Modified on 20 January 2013 (Sunday)
  * 
@@ -12,40 +13,128 @@
  */
 
 #include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
 #include "getLine.h"
-#include "getwc.h"
+#include "rawInput.h"
 
-char* getLine(FILE* fp)
+#define MEM_SUBSYSTEM MEM_GETLINE
+#include "memStats.h"
+
+// initial size of the buffer lines are read into
+#define LINE_BUFFER_SIZE (128)
+
+// number of lines returned by getLine() so far
+static unsigned long lineCount = 0;
+
+// if non-NULL, supplies lines in place of the file pointer
+static char* (*lineSource)(void) = NULL;
+
+// if non-NULL, called with each line returned
+static void (*lineObserver)(const char* line) = NULL;
+
+unsigned long getLineCount(void)
+{
+    return lineCount;
+}
+
+void setLineSource(char* (*source)(void))
+{
+    lineSource = source;
+}
+
+void setLineObserver(void (*observer)(const char* line))
 {
-    char* line; // Line being read
-    int size;   // #chars allocated
+    lineObserver = observer;
+}
+
+// Reads a line from fp as described at the top of this file. The line is
+// gathered in a buffer kept from line to line, so each line costs one
+// allocation of exactly its size.
+static char* readLine(FILE* fp)
+{
+    static char* buffer = NULL; // Line being read
+    static int size = 0;        // #chars allocated
+    char* line;
     int c, i;
 
-    size = sizeof(double); // Minimum allocation
-    line = malloc(size);
-    for(i = 0; (c = getwc(fp)) != EOF; )
+    for(i = 0; (c = inputGetc(fp)) != EOF; )
     {
-        if(i == size-1)
+        if(i >= size-1)
         {
-	        size *= 2; // Double allocation
-	        line = realloc(line, size);
-	    }
-	    line[i++] = c;
-	    if(c == '\n')
+            size = size ? size * 2 : LINE_BUFFER_SIZE; // Double allocation
+            buffer = realloc(buffer, size);
+        }
+        buffer[i++] = c;
+        if(c == '\n')
         {
-	        break;
+            break;
         }
     }
 
     // Check for immediate EOF
-    if(c == EOF && i == 0) 
+    if(c == EOF && i == 0)
     {
-	    free (line);
-	    return NULL;
+        return NULL;
     }
 
-    line[i++] = '\0';         // Terminate line
-    line = realloc(line, i);  // Trim excess storage
+    line = malloc(i + 1);
+    memcpy(line, buffer, i);
+    line[i] = '\0'; // Terminate line
+
+    return line;
+}
+
+char* getLine(FILE* fp)
+{
+    char* line = lineSource ? lineSource() : readLine(fp);
+
+    if(line)
+    {
+        lineCount++;
+        if(lineObserver)
+        {
+            lineObserver(line);
+        }
+    }
+
+    return line;
+}
+
+// Returns true if the line of length len ends in a backslash-newline, that is,
+// a newline preceded by an odd number of backslashes
+static bool endsInContinuation(char* line, size_t len)
+{
+    if(len < 2 || line[len - 1] != '\n')
+    {
+        return false;
+    }
+
+    size_t nBackslashes = 0;
+    for(size_t i = len - 1; i > 0 && line[i - 1] == '\\'; i--)
+    {
+        nBackslashes++;
+    }
+    return nBackslashes % 2 == 1;
+}
+
+char* getJoinedLine(FILE* fp)
+{
+    char* line = getLine(fp);
+    size_t len = line ? strlen(line) : 0;
+
+    while(endsInContinuation(line, len))
+    {
+        len -= 2; // drop the backslash-newline
+
+        char* next = getLine(fp);
+        size_t nextLen = next ? strlen(next) : 0;
+
+        line = realloc(line, len + nextLen + 1);
+        memcpy(line + len, next ? next : "", nextLen + 1);
+        len += nextLen;
+        free(next);
+    }
 
     return line;
 }
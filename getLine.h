@@ -1,6 +1,7 @@
 /* 
  * File:   getLine.c
  * Author: Stan Eisenstat
+ * Modified by: agent (agent@local)
  * 
  * Read a line of text using the file pointer *fp and returns a pointer to a
  * malloc'd null-terminated string that contains the text read, including the
@@ -11,3 +12,21 @@
 #include <stdio.h>
 
 char* getLine(FILE* fp);
+
+// Returns a line read by getLine(), joined with the lines that follow it while
+// it ends in a backslash-newline (a newline preceded by an odd number of
+// backslashes), which is removed. Returns NULL on end of file.
+char* getJoinedLine(FILE* fp);
+
+// Returns the number of lines returned by getLine() so far, which is the line
+// number of the last line read
+unsigned long getLineCount(void);
+
+// Makes getLine() return the malloc'd lines returned by source instead of
+// reading from its file pointer. source returns NULL at the end of its input.
+// A NULL source restores reading from the file pointer.
+void setLineSource(char* (*source)(void));
+
+// Makes getLine() call observer with each line it returns before returning it.
+// A NULL observer removes the observer.
+void setLineObserver(void (*observer)(const char* line));
@@ -1,6 +1,7 @@
 /* 
  * File:   getwc.c
  * Author: Alexander Schurman (alexander.schurman@gmail.com)
+ * Modified by: agent (agent@local)
  *
  * Created on 20 January 2013 (Sunday)
  * 
@@ -8,30 +9,59 @@
  * character if successful, EOF on end of file, or BAD_INPUT if the input is
  * invalid (reaches EOF before parsing a single ASCII char, non-whitespace
  * input)
+ *
+ * Also decodes blocks of whitespace already in memory with decodeWhitespace(),
+ * and holds the readers and decoders for plain text input selected in its
+ * place by setInputMode()
  */
 
-#ifndef NORMAL_INPUT
-
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
 #include <assert.h>
 #include "getwc.h"
 
-#define IS_WHITESPACE(c) (c == ' ' || c == '\t')
+#define IS_WHITESPACE(c) (c == WS_ONE || c == WS_ZERO)
+
+size_t decodeWhitespace(const char* in, size_t nChars, char* out)
+{
+    for(size_t n = 0; n < nChars; n++, in += WS_BITS)
+    {
+        // decode all of the bits before checking them so that the loop
+        // unrolls without a branch per bit
+        unsigned char outchar = 0;
+        bool invalid = false;
+        for(int i = 0; i < WS_BITS; i++)
+        {
+            outchar = (outchar << 1) | (in[i] == WS_ONE);
+            invalid |= !IS_WHITESPACE(in[i]);
+        }
+
+        if(invalid)
+        {
+            return n;
+        }
+        out[n] = outchar;
+    }
+
+    return nChars;
+}
 
-int getwc(FILE* fp)
+// Reads a character of white-space input; inputGetwc in INPUT_WHITESPACE mode
+static int getWhitespace(FILE* fp)
 {
     // return value if a character is parsed from whitespace;
     char outchar = 0;
 
-    for(unsigned char i = 0x40; i; i >>= 1)
+    for(unsigned char i = 1 << (WS_BITS - 1); i; i >>= 1)
     {
         int c = getc(fp);
         if(c == EOF || !IS_WHITESPACE(c))
         {
             return EOF;
         }
-        else if(c == ' ') // space -> 1, tab -> 0
+        else if(c == WS_ONE) // space -> 1, tab -> 0
         {
             outchar |= i;
         }
@@ -44,4 +74,42 @@ int getwc(FILE* fp)
     return outchar;
 }
 
+// Reads a character of plain text input; inputGetwc in INPUT_NORMAL mode
+static int getNormal(FILE* fp)
+{
+    return getc(fp);
+}
+
+// Copies plain text input; decodeInput in INPUT_NORMAL mode
+static size_t decodeNormal(const char* in, size_t nChars, char* out)
+{
+    memcpy(out, in, nChars);
+    return nChars;
+}
+
+#ifdef NORMAL_INPUT
+int (*inputGetwc)(FILE* fp) = getNormal;
+int inputCharWidth = 1;
+size_t (*decodeInput)(const char* in, size_t nChars, char* out) = decodeNormal;
+#else
+int (*inputGetwc)(FILE* fp) = getWhitespace;
+int inputCharWidth = WS_BITS;
+size_t (*decodeInput)(const char* in, size_t nChars, char* out) =
+    decodeWhitespace;
 #endif
+
+void setInputMode(int mode)
+{
+    if(mode == INPUT_NORMAL)
+    {
+        inputGetwc = getNormal;
+        inputCharWidth = 1;
+        decodeInput = decodeNormal;
+    }
+    else
+    {
+        inputGetwc = getWhitespace;
+        inputCharWidth = WS_BITS;
+        decodeInput = decodeWhitespace;
+    }
+}
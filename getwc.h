@@ -1,21 +1,50 @@
-/* 
+/*
  * File:   getwc.h
  * Author: Alexander Schurman (alexander.schurman@gmail.com)
+ * Modified by: agent (agent@local)
  *
  * Created on 20 January 2013 (Sunday)
- * 
+ *
  * Gets a single ASCII character from whitespace char input. Returns the
  * character if successful, EOF on end of file or bad input.
- * input)
+ *
+ * The input mode, white-space or plain text, is selected at run time.
  */
 
 #ifndef GETWCHAR_H
 #define GETWCHAR_H
 
-#ifdef NORMAL_INPUT
-#define getwc(x) (getc(x))
-#else
-int getwc(FILE* fp);
-#endif
+#include <stdio.h>
+
+// Each ASCII character is encoded as WS_BITS white-space characters, most
+// significant bit first (the always-zero eighth bit is left out), with WS_ONE
+// encoding a 1 and WS_ZERO encoding a 0
+#define WS_BITS (7)
+#define WS_ONE  (' ')
+#define WS_ZERO ('\t')
+
+// Input modes: white-space encoded, or plain text as in a typical shell
+enum { INPUT_WHITESPACE, INPUT_NORMAL };
+
+// Selects the input mode by pointing inputGetwc and decodeInput at the reader
+// and decoder for it, so that neither branches on the mode. The default is
+// INPUT_WHITESPACE, or INPUT_NORMAL if compiled with NORMAL_INPUT defined.
+void setInputMode(int mode);
+
+// Reads a single character from fp in the current input mode
+extern int (*inputGetwc)(FILE* fp);
+
+// Number of input chars that encode each character in the current input mode
+// (WS_BITS or 1)
+extern int inputCharWidth;
+
+// Decodes the nChars characters encoded in the nChars * inputCharWidth chars
+// at in, writing them to out. Stops at the first character whose encoding is
+// invalid, as inputGetwc() does. Returns the number of characters decoded.
+extern size_t (*decodeInput)(const char* in, size_t nChars, char* out);
+
+// decodeInput in INPUT_WHITESPACE mode: stops at the first character whose
+// encoding contains a char other than WS_ONE or WS_ZERO
+size_t decodeWhitespace(const char* in, size_t nChars, char* out);
 
 #endif
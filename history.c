@@ -0,0 +1,389 @@
+/*
+ * File:   history.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the shell's history described in history.h. The file is
+ * mapped once, with address space reserved for it to grow into, so the text
+ * of an entry stays put however much other sessions append.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "history.h"
+#include "cacheDir.h"
+
+#define MEM_SUBSYSTEM MEM_GETLINE
+#include "memStats.h"
+
+#define HISTORY_MAGIC "EGGHIST2"
+
+// the history's directory under $HOME/.eggshell, and its file there
+#define HISTORY_DIR "history"
+#define HISTORY_FILE "commands"
+
+// the prefix lengths indexed; the first chains every entry. A prefix up to 8
+// characters long follows a chain of only the entries that match it.
+static const size_t levelLength[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 24,
+                                      32 };
+#define HISTORY_LEVELS (sizeof(levelLength) / sizeof(levelLength[0]))
+
+// slots in the table of each prefix length
+#define HISTORY_BUCKETS (1 << 16)
+
+// bytes the file grows by when an entry doesn't fit, and the most it can hold
+#define HISTORY_GROWTH (1 << 20)
+#define HISTORY_MAX_SIZE (1ULL << 36)
+
+typedef struct {
+    char magic[8];           // HISTORY_MAGIC
+    unsigned long long end;  // the offset past the last entry
+    unsigned long long count; // the number of entries
+
+    // the offset of the last entry with each prefix of each length, or 0
+    unsigned long long heads[HISTORY_LEVELS][HISTORY_BUCKETS];
+} historyHeader;
+
+typedef struct {
+    // the offset of the entry before it with the same prefix of each length,
+    // or 0
+    unsigned long long prev[HISTORY_LEVELS];
+    unsigned long long number;
+    unsigned long long len;
+    char text[];             // len bytes and a null
+} historyEntry;
+
+// the bytes taken by an entry with text of length len, keeping entries
+// aligned
+#define ENTRY_SIZE(len) ((sizeof(historyEntry) + (len) + 1 + 7) & ~7ULL)
+
+// the history file, and its mapping
+static int historyFd = -1;
+static char* history = NULL;
+#define HEADER ((historyHeader*)history)
+
+// Returns the level whose prefix length is the longest at most len
+static size_t levelFor(size_t len)
+{
+    size_t level = HISTORY_LEVELS - 1;
+    while(levelLength[level] > len)
+    {
+        level--;
+    }
+    return level;
+}
+
+// Returns the slot in the table of level for text, which is at least as long
+// as its prefix length. The shortest prefixes are their own slots.
+static size_t bucketOf(size_t level, const char* text)
+{
+    size_t len = levelLength[level];
+    if(len <= 2)
+    {
+        size_t bucket = 0;
+        for(size_t i = 0; i < len; i++)
+        {
+            bucket = (bucket << 8) | (unsigned char)text[i];
+        }
+        return bucket;
+    }
+    return cacheHash(text, len, level) & (HISTORY_BUCKETS - 1);
+}
+
+// Returns the entry at offset in a history that ends at end, or NULL if there
+// is none there
+static historyEntry* entryAt(unsigned long long offset,
+                             unsigned long long end)
+{
+    if(offset < sizeof(historyHeader) || end < offset ||
+       end - offset < sizeof(historyEntry))
+    {
+        return NULL;
+    }
+
+    historyEntry* entry = (historyEntry*)(history + offset);
+    if(entry->len >= end - offset || ENTRY_SIZE(entry->len) > end - offset)
+    {
+        return NULL;
+    }
+    return entry;
+}
+
+// Sets *item to entry, found at offset in a history that ends at end
+static void setItem(historyItem* item, historyEntry* entry,
+                    unsigned long long offset, unsigned long long end)
+{
+    item->number = entry->number;
+    item->text = entry->text;
+    item->len = entry->len;
+    item->offset = offset;
+    item->end = end;
+}
+
+int openHistory(const char* path)
+{
+    char* file;
+    if(path && *path)
+    {
+        file = strdup(path);
+    }
+    else
+    {
+        char* dir = cacheDir(HISTORY_DIR);
+        if(!dir)
+        {
+            fprintf(stderr, "eggshell: history: Can't create "
+                    "$HOME/.eggshell/" HISTORY_DIR "\n");
+            return -1;
+        }
+        size_t len = strlen(dir) + strlen(HISTORY_FILE) + 2;
+        file = malloc(len);
+        snprintf(file, len, "%s/%s", dir, HISTORY_FILE);
+        free(dir);
+    }
+
+    int fd = open(file, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    struct stat st;
+    if(fd < 0 || flock(fd, LOCK_EX) < 0 || fstat(fd, &st) < 0)
+    {
+        perror(file);
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+        free(file);
+        return -1;
+    }
+
+    // a new file is given its header and room to grow
+    bool created = (st.st_size == 0);
+    if(created &&
+       ftruncate(fd, sizeof(historyHeader) + HISTORY_GROWTH) < 0)
+    {
+        perror(file);
+        close(fd);
+        free(file);
+        return -1;
+    }
+
+    history = mmap(NULL, HISTORY_MAX_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   fd, 0);
+    if(history == MAP_FAILED)
+    {
+        perror(file);
+        history = NULL;
+        close(fd);
+        free(file);
+        return -1;
+    }
+
+    if(created)
+    {
+        memcpy(HEADER->magic, HISTORY_MAGIC, sizeof(HEADER->magic));
+        HEADER->end = sizeof(historyHeader);
+    }
+    else if((size_t)st.st_size < sizeof(historyHeader) ||
+            memcmp(HEADER->magic, HISTORY_MAGIC, sizeof(HEADER->magic)) != 0)
+    {
+        fprintf(stderr, "eggshell: %s: Not a history file\n", file);
+        munmap(history, HISTORY_MAX_SIZE);
+        history = NULL;
+        close(fd);
+        free(file);
+        return -1;
+    }
+
+    flock(fd, LOCK_UN);
+    historyFd = fd;
+    free(file);
+    return 0;
+}
+
+// Appends the len bytes at text to the history
+static void addHistory(const char* text, size_t len)
+{
+    struct stat st;
+    if(flock(historyFd, LOCK_EX) < 0)
+    {
+        return;
+    }
+
+    // grow the file if the entry doesn't fit
+    unsigned long long offset = HEADER->end;
+    unsigned long long size = ENTRY_SIZE(len);
+    if(fstat(historyFd, &st) < 0 || offset + size > HISTORY_MAX_SIZE ||
+       (offset + size > (unsigned long long)st.st_size &&
+        ftruncate(historyFd, offset + size + HISTORY_GROWTH) < 0))
+    {
+        flock(historyFd, LOCK_UN);
+        return;
+    }
+
+    historyEntry* entry = (historyEntry*)(history + offset);
+    for(size_t level = 0; level < HISTORY_LEVELS; level++)
+    {
+        entry->prev[level] = (len >= levelLength[level]) ?
+                             HEADER->heads[level][bucketOf(level, text)] : 0;
+    }
+    entry->number = HEADER->count + 1;
+    entry->len = len;
+    memcpy(entry->text, text, len);
+    entry->text[len] = '\0';
+
+    // the entry is added before it is indexed, so that if the shell dies in
+    // between, the index never points past the end
+    HEADER->end = offset + size;
+    HEADER->count++;
+    for(size_t level = 0; level < HISTORY_LEVELS; level++)
+    {
+        if(len >= levelLength[level])
+        {
+            HEADER->heads[level][bucketOf(level, text)] = offset;
+        }
+    }
+
+    flock(historyFd, LOCK_UN);
+}
+
+bool findHistory(const char* prefix, size_t len, const historyItem* before,
+                 historyItem* item)
+{
+    if(historyFd < 0)
+    {
+        return false;
+    }
+
+    size_t level = levelFor(len);
+    unsigned long long offset, end;
+    if(before)
+    {
+        end = before->end;
+        historyEntry* entry = entryAt(before->offset, end);
+        offset = entry ? entry->prev[level] : 0;
+    }
+    else
+    {
+        if(flock(historyFd, LOCK_SH) < 0)
+        {
+            return false;
+        }
+        end = HEADER->end;
+        offset = (len >= levelLength[level]) ?
+                 HEADER->heads[level][bucketOf(level, prefix)] : 0;
+        flock(historyFd, LOCK_UN);
+    }
+
+    // each entry's chain goes back to earlier ones, so a damaged file can't
+    // loop
+    for(historyEntry* entry; (entry = entryAt(offset, end)) != NULL; )
+    {
+        if(entry->len >= len && memcmp(entry->text, prefix, len) == 0)
+        {
+            setItem(item, entry, offset, end);
+            return true;
+        }
+        if(entry->prev[level] >= offset)
+        {
+            break;
+        }
+        offset = entry->prev[level];
+    }
+    return false;
+}
+
+// Sets *item to the entry that the event word, of length len, after a ! refers
+// to. Returns false if there is none.
+static bool findEvent(const char* word, size_t len, historyItem* item)
+{
+    if(len == 1 && word[0] == '!')
+    {
+        return findHistory("", 0, NULL, item);
+    }
+
+    // !n and !-n are found by counting back from the last entry
+    bool relative = (word[0] == '-');
+    size_t digits = strspn(word + relative, "0123456789");
+    if(digits == 0 || relative + digits != len)
+    {
+        return findHistory(word, len, NULL, item);
+    }
+
+    unsigned long long n = strtoull(word + relative, NULL, 10);
+    if(n == 0 || !findHistory("", 0, NULL, item))
+    {
+        return false;
+    }
+    if(relative)
+    {
+        for(unsigned long long back = 1; back < n; back++)
+        {
+            if(!findHistory("", 0, item, item))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    while(item->number > n)
+    {
+        if(!findHistory("", 0, item, item))
+        {
+            return false;
+        }
+    }
+    return item->number == n;
+}
+
+char* historyLine(char* line)
+{
+    if(historyFd < 0)
+    {
+        return line;
+    }
+
+    char* start = line + strspn(line, " \t");
+    if(start[0] == '!' && start[1] && !isspace((unsigned char)start[1]))
+    {
+        char* word = start + 1;
+        size_t wordLen = strcspn(word, " \t\n");
+        historyItem item;
+        if(!findEvent(word, wordLen, &item))
+        {
+            fprintf(stderr, "%.*s: Event not found.\n", (int)wordLen, word);
+            free(line);
+            return NULL;
+        }
+
+        // the entry's text replaces the reference
+        char* rest = word + wordLen;
+        char* expanded = malloc(item.len + strlen(rest) + 1);
+        memcpy(expanded, item.text, item.len);
+        strcpy(expanded + item.len, rest);
+        free(line);
+        line = expanded;
+
+        fputs(line, stdout);
+        fflush(stdout);
+    }
+
+    size_t len = strlen(line);
+    if(len > 0 && line[len - 1] == '\n')
+    {
+        len--;
+    }
+    if(strspn(line, " \t") < len)
+    {
+        addHistory(line, len);
+    }
+    return line;
+}
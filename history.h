@@ -0,0 +1,57 @@
+/*
+ * File:   history.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for the shell's history: the command lines typed in every
+ * session, appended to one file that concurrent sessions share.
+ *
+ * The file starts with a header holding an index, followed by the entries,
+ * each with its number and text. An entry is never changed once written, so
+ * it is read straight from the mapped file without a lock; appending an entry
+ * and reading the index take flock() locks, exclusive and shared. The index
+ * chains each entry to the one before it that starts with the same 1 to 8,
+ * 12, 16, 24, or 32 characters (and to the one before it overall), and holds
+ * the latest entry of each chain in a table, so that the latest entries with
+ * a given prefix are found by following the chain of the longest of those
+ * lengths it has. Opening the file maps it without reading any of it.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// An entry in the history
+typedef struct {
+    unsigned long long number; // its number, counting from 1
+    const char* text;          // its text, without a newline
+    size_t len;                //   and the length of its text
+    unsigned long long offset; // where it is in the file
+    unsigned long long end;    // the end of the history when it was found
+} historyItem;
+
+// Opens the history file path, or $HOME/.eggshell/history/commands if path is
+// NULL or empty, creating it if necessary. Returns 0, or -1 after printing an
+// error if it can't be opened.
+int openHistory(const char* path);
+
+// Expands a history reference at the start of the malloc'd line, which is
+// freed if it is replaced: !! is the last entry, !n the entry numbered n, !-n
+// the nth entry back, and !prefix the last entry starting with prefix. An
+// expanded line is echoed to stdout. Adds the line to the history, unless it
+// is blank, and returns it, or returns NULL after freeing line and printing
+// an error if the reference has no entry.
+char* historyLine(char* line);
+
+// Sets *item to the last entry starting with the len bytes at prefix, if
+// before is NULL, or else the last one before *before, which must have been
+// found with the same prefix. item may be before. Returns false if there is
+// no such entry (or no history). Safe to call from any thread; the text of
+// an entry is valid until the shell exits.
+bool findHistory(const char* prefix, size_t len, const historyItem* before,
+                 historyItem* item);
+
+#endif
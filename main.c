@@ -2,6 +2,7 @@
  * File:   main.c
  * Original Author: Stan Eisenstat
  * Modified by: Alexander Schurman (alexander.schurman@gmail.com)
+ * Modified by: agent (agent@local)
  *
  * Modified on 20 January 2013 (Sunday)
  * 
@@ -12,414 +13,314 @@
 #define _GNU_SOURCE
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
 #include <ctype.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
 #include "getLine.h"
 #include "parse.h"
 #include "process.h"
+#include "profile.h"
+#include "record.h"
+#include "replay.h"
+#include "script.h"
+#include "readAhead.h"
+#include "rawInput.h"
+#include "getwc.h"
+#include "server.h"
+#include "zygote.h"
+#include "history.h"
+
+#define MEM_SUBSYSTEM MEM_PARSE
+#include "memStats.h"
+
+// run under this name, the shell reads normal input rather than white space
+#define NORMAL_INPUT_NAME "eggnorm"
+
+// workers forked in advance by -S unless -w says otherwise
+#define DEFAULT_WORKERS (4)
+
+// status of a command line that doesn't parse
+#define SYNTAX_ERROR_STATUS (2)
+
+// Prints the command-line usage to stderr
+void usage(char* name)
+{
+    fprintf(stderr, "Usage: %s [-N | -W] [-p] [-a depth] [-r log] "
+            "[-R log [-P]] [-S socket [-w workers]] [-z] [script]\n", name);
+    fprintf(stderr, "  -N        read normal input\n");
+    fprintf(stderr, "  -W        read white-space input\n");
+    fprintf(stderr, "  -p        profile each script line, reporting at "
+            "exit\n");
+    fprintf(stderr, "  -a depth  parse up to depth script lines ahead of "
+            "execution\n");
+    fprintf(stderr, "  -r log    record the session to log\n");
+    fprintf(stderr, "  -R log    replay the session recorded in log\n");
+    fprintf(stderr, "  -P        replay with the original pacing\n");
+    fprintf(stderr, "  -S socket serve eggclient requests on socket\n");
+    fprintf(stderr, "  -w n      fork n workers to serve requests "
+            "(default %d)\n", DEFAULT_WORKERS);
+    fprintf(stderr, "  -z        launch commands from a zygote process\n");
+}
 
 int main(int argc, char** argv)
 {
-    int nCmd = 1; // Command number
-    char *line;   // Initial command line
-    token *list;  // Linked list of tokens
-    CMD *cmd;     // Parsed command
-
-    for( ; ; free(line))
-    {
-        // Prompt for command
-        printf("(%d)$ ", nCmd);
-        fflush(stdout);
-
-        // Read line
-        if((line = getLine(stdin)) == NULL)
-	    {
-            break; // Break on end of file
-        }
-
-        // Lex line into tokens
-	    if((list = tokenize(line)) == NULL)
+    int nCmd = 1;           // Command number
+    char prompt[32];        // Prompt for the command
+    char *line;             // Initial command line
+    unsigned long lineNum = 0; // Source line number of line
+    token *list;            // Linked list of tokens
+    CMD *cmd;               // Parsed command
+    int status = 0;         // Exit status of cmd
+    char *replayLog = NULL; // Session log to replay
+    bool paced = false;     //   and whether to replay with original pacing
+    bool streaming = true;  // Lex straight from stdin? (false if whole lines
+                            //   are needed or come from elsewhere)
+    bool atEOF;             // Reached end of file while lexing?
+    int readAheadDepth = 0; // Lines to parse ahead of execution (0 for none)
+    bool recording = false; // Recording the session?
+    bool scriptLoaded = false; // Loaded the script whole?
+    bool readingAhead = false; // Parsing on the read-ahead thread?
+    char *socketPath = NULL; // Socket to serve requests on
+    int nWorkers = DEFAULT_WORKERS; // Workers serving requests
+    char *command = NULL;   // Command line sent with a request
+    int scriptFd = -1;      // Script to run (-1 for standard input)
+    bool useZygote = false; // Launch commands from a zygote?
+    bool keepHistory = false; // Adding the lines read to the history?
+    int opt;
+
+    char* name = strrchr(argv[0], '/');
+    if(strcmp(name ? name + 1 : argv[0], NORMAL_INPUT_NAME) == 0)
+    {
+        setInputMode(INPUT_NORMAL);
+    }
+
+    while((opt = getopt(argc, argv, "NWpa:r:R:PS:w:z")) != -1)
+    {
+        switch(opt)
         {
-            continue;
+            case 'N':
+                setInputMode(INPUT_NORMAL);
+                break;
+
+            case 'W':
+                setInputMode(INPUT_WHITESPACE);
+                break;
+
+            case 'p':
+                startProfile(stderr);
+                streaming = false;
+                break;
+
+            case 'a':
+                readAheadDepth = atoi(optarg);
+                break;
+
+            case 'r':
+                if(startRecording(optarg) < 0)
+                {
+                    perror(optarg);
+                    return EXIT_FAILURE;
+                }
+                recording = true;
+                streaming = false;
+                break;
+
+            case 'R':
+                replayLog = optarg;
+                streaming = false;
+                break;
+
+            case 'P':
+                paced = true;
+                break;
+
+            case 'S':
+                socketPath = optarg;
+                break;
+
+            case 'w':
+                nWorkers = atoi(optarg);
+                if(nWorkers < 1)
+                {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case 'z':
+                useZygote = true;
+                break;
+
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
         }
-
-	    if ((cmd = parse(list)) != NULL) // Parsed command?
-        {
-            process(cmd); // Execute command
-            freeCMD(cmd); // Free associated storage
-            nCmd++;       // Adjust prompt
-        }
-
-        freeList(list); // Free token list
     }
 
-    return EXIT_SUCCESS;
-}
-
-
-// Allocate, initialize, and return a pointer to an empty command structure
-CMD* mallocCMD()
-{
-    CMD* new = malloc(sizeof(CMD));
-
-    new->type     = NONE;
-    new->argc     = 0;
-    new->argv     = malloc(sizeof(char*));
-    new->argv[0]  = NULL;
-    new->fromType = NONE;
-    new->fromFile = NULL;
-    new->toType   = NONE;
-    new->toFile   = NULL;
-    new->left     = NULL;
-    new->right    = NULL;
-
-    return new;
-}
-
-
-// Print arguments in command data structure rooted at *c
-void dumpArgs(CMD* c)
-{
-    for(char **q = c->argv; *q; q++)
-    {
-        printf(",  argv[%d] = %s", q-(c->argv), *q);
-    }
-}
-
-
-// Print input/output redirections in command data structure rooted at *c
-void dumpRedirect(CMD* c)
-{
-    if(c->fromType == NONE && c->fromFile == NULL)
-    {
-	    ;
-    }
-    else if(c->fromType == RED_IN && c->fromFile != NULL)
-    {
-	    printf("  <%s", c->fromFile);
-    }
-    else if(c->fromType == RED_HERE && c->fromFile != NULL)
-    {
-	    printf("  <HERE");
-    }
-    else
+    // returns in a worker, with the request's command line or script
+    if(socketPath && serve(socketPath, nWorkers, &command, &scriptFd) < 0)
     {
-	    printf("  ILLEGAL INPUT REDIRECTION");
+        return EXIT_FAILURE;
     }
 
-    if (c->toType == NONE && c->toFile == NULL)
+    // fork the zygote while the heap is still small
+    if(useZygote && startZygote() < 0)
     {
-	    ;
-    }
-    else if(c->toType == RED_OUT       && c->toFile != NULL)
-    {
-        printf("  >%s",   c->toFile);
-    }
-    else if(c->toType == RED_OUT_C     && c->toFile != NULL)
-    {
-	    printf("  >!%s",  c->toFile);
-    }
-    else if(c->toType == RED_OUT_APP   && c->toFile != NULL)
-    {
-	    printf("  >>%s",  c->toFile);
-    }
-    else if(c->toType == RED_OUT_APP_C && c->toFile != NULL)
-    {
-	    printf("  >>!%s", c->toFile);
-    }
-    else if(c->toType == RED_ERR       && c->toFile != NULL)
-    {
-	    printf("  >&%s",   c->toFile);
-    }
-    else if(c->toType == RED_ERR_C     && c->toFile != NULL)
-    {
-	    printf("  >&!%s",  c->toFile);
-    }
-    else if(c->toType == RED_ERR_APP   && c->toFile != NULL)
-    {
-	    printf("  >>&%s",  c->toFile);
-    }
-    else if(c->toType == RED_ERR_APP_C && c->toFile != NULL)
-    {
-	    printf("  >>&!%s", c->toFile);
-    }
-    else
-    {
-	    printf("  ILLEGAL OUTPUT REDIRECTION");
+        perror("eggshell: zygote");
     }
 
-    if(c->fromType == RED_HERE && c->fromFile != NULL)
+    if(command) // run a single command line and exit
     {
-	    printf("\n         HERE:  ");
-	    for(char *s = c->fromFile; *s; s++)
+        if((list = tokenize(command)) != NULL)
         {
-	        if(*s != '\n')
-            {
-		        fputc(*s, stdout);
-            }
-	        else if(s[1])
-            {
-		        printf("\n         HERE:  ");
-            }
-	    }
-    }
-}
-
-
-// Print command data structure rooted at *c at level LEVEL
-void dumpSimple(CMD* c, int level)
-{
-    printf("level = %d,  argc = %d", level, c->argc);
-
-    if(c->type == SIMPLE)
-    {
-	    dumpArgs(c);
-    }
-    else if(c->type == PIPE)
-    {
-	    printf(",  PIPE");
-    }
-    else if(c->type == PIPE_ERR)
-    {
-	    printf(",  PIPE_ERR");
+            cmd = parse(list);
+            status = cmd ? process(cmd) : SYNTAX_ERROR_STATUS;
+            freeCMD(cmd);
+            freeList(list);
+        }
+        free(command);
+        finishRequest(status);
+        return status;
     }
-    else if(c->type == SUBCMD)
+    else if(!socketPath && !replayLog && optind < argc)
     {
-	    printf(",  SUBCMD");
+        // read commands from a script file
+        if((scriptFd = open(argv[optind], O_RDONLY)) < 0)
+        {
+            perror(argv[optind]);
+            return EXIT_FAILURE;
+        }
     }
 
-    dumpRedirect(c);
-}
-
-
-// Print command data structure rooted at *c; return SEP_END or SEP_BG
-int dumpType(CMD* c, int level)
-{
-    int type = SEP_END;
-
-    if(c->argc < 0)
-    {
-	    printf("  ARGC < 0");
-    }
-    else if(c->argv == NULL)
-    {
-	    printf("  ARGV = NULL");
-    }
-    else if(c->argv[c->argc] != NULL)
+    // keep the history of commands typed at a terminal, or read from standard
+    // input if EGGSHELL_HISTORY names a file for it
+    if(!socketPath && !replayLog && scriptFd < 0 &&
+       (isatty(STDIN_FILENO) || getenv("EGGSHELL_HISTORY")))
     {
-	    printf("  ARGV[ARGC] != NULL");
+        keepHistory = (openHistory(getenv("EGGSHELL_HISTORY")) == 0);
     }
 
-    if(c->type == SIMPLE)
+    if(replayLog)
     {
-	    dumpSimple(c, level);
-	    if(c->left != NULL)
-        {
-	        printf("  <simple> HAS LEFT CHILD");
-        }
-	    if(c->right != NULL)
+        if(startReplay(replayLog, paced) < 0)
         {
-	        printf("  <simple> HAS RIGHT CHILD");
+            return EXIT_FAILURE;
         }
     }
-    else if(c->argc > 0 || c->argv == NULL || c->argv[0] != NULL)
+    else if(scriptFd >= 0)
     {
-	    printf("  INVALID ARGUMENT LIST IN NON-SIMPLE");
-    }
-    else if(c->type == SUBCMD)
-    {
-	    dumpSimple(c, level);
-	    printf("\nCMD:   ");
-	    type = dumpType(c->left, level+1);
-	    if (c->right)
+        // if the script can't be loaded whole (e.g., it's a pipe), read it
+        // as standard input
+        if(loadScript(scriptFd) == 0)
         {
-	        printf("  SUBCMD INVALID");
+            scriptLoaded = true;
+            streaming = false;
         }
-	    char sep = (type == SEP_BG) ? '&' : ';';
-	    printf("  %c", sep);
-	    type = SEP_END;
-
-    }
-    else if(c->fromType != NONE ||
-            c->fromFile != NULL ||
-	        c->toType != NONE   ||
-	        c->toFile != NULL)
-    {
-	    printf("  INVALID I/O REDIRECTION IN NON-SIMPLE NON-SUBCMD");
-    }
-    else if(ISPIPE(c->type))
-    {
-	    dumpSimple (c, level);
-	    printf("\nCMD:   ");
-	    type = dumpType(c->left, level+1);
-	    char* pipe = (c->type == PIPE) ? "|" : "|&";
-	    printf("  %s\nCMD: | ", pipe);
-
-	    CMD* p;
-	    for(p = c->right; ISPIPE (p->type); p = p->right)
+        else
         {
-	        type = dumpType(p->left, level+1);
-	        char *pipe = (p->type == PIPE) ? "|" : "|&";
-	        printf("  %s\nCMD: | ", pipe);
-	    }
-	    type = dumpType(p, level+1);
-	    char sep = (type == SEP_BG) ? '&' : ';';
-	    printf("  %c", sep);
-	    type = SEP_END;
-    }
-    else if(c->type == SEP_AND)
-    {
-	    type = dumpType(c->left, level);
-	    printf("  &&\nCMD:   ");
-	    type = dumpType(c->right, level);
-    }
-    else if(c->type == SEP_OR)
-    {
-	    type = dumpType(c->left, level);
-    	printf("  ||\nCMD:   ");
-	    type = dumpType(c->right, level);
-    }
-    else if(c->type == SEP_END)
-    {
-	    type = dumpType(c->left, level);
-	    if(c->right)
-        {
-	        char sep = (type == SEP_BG) ? '&' : ';';
-	        printf("  %c\nCMD:   ", sep);
-	        type = dumpType(c->right, level);
-	    }
-    }
-    else if(c->type == SEP_BG)
-    {
-	    dumpType(c->left, level);
-	    type = SEP_BG;
-	    if (c->right)
-        {
-	        printf("  &\nCMD:   ");
-	        type = dumpType(c->right, level);
-	    }
+            dup2(scriptFd, STDIN_FILENO);
+        }
+        close(scriptFd);
     }
-    else
+    else if(loadScript(STDIN_FILENO) == 0) // load a regular file whole
     {
-	    printf("  ILLEGAL CMD TYPE");
+        scriptLoaded = true;
+        streaming = false;
     }
 
-    return type;
-}
-
-
-// Print command data structure rooted at *c
-void dumpCMD(CMD* c, int level)
-{
-    printf("CMD:   ");
-    int type = dumpType(c, level);
-    char sep = (type == SEP_BG) ? '&' : ';';
-    printf("  %c\n", sep);
-}
-
-
-// Free tree of commands rooted at *c
-void freeCMD(CMD* c)
-{
-    if(!c)
+    // a loaded script can be parsed ahead, unless its lines are recorded as
+    // they're read, since they'd be logged out of order with the statuses, or
+    // added to the history, which may change them
+    if(readAheadDepth > 0 && scriptLoaded && !recording && !keepHistory)
     {
-	    return;
+        readingAhead = (startReadAhead(readAheadDepth) == 0);
     }
 
-    for(char** p = c->argv; *p; p++)
+    if(keepHistory) // whole lines are needed for the history
     {
-	    free(*p);
+        streaming = false;
     }
-    free(c->argv);
-
-    free(c->fromFile);
-    free(c->toFile);
 
-    freeCMD(c->left);
-    freeCMD(c->right);
-
-    free(c);
-}
-
-
-// Print list of tokens LIST
-void dumpList(struct token* list)
-{
-    struct token* p;
-
-    for(p = list;  p != NULL;  p = p->next) // Walk down linked list
+    if(streaming) // read standard input with read() rather than stdio
     {
-	    printf("%s:%d ", p->text, p->type); //   printing token and type
+        startRawInput(stdin);
     }
-    putchar('\n'); // Terminate line
-}
-
 
-// Free list of tokens LIST
-void freeList(token* list)
-{
-    token *p, *pnext;
-    for(p = list; p; p = pnext)
+    for( ; ; free(line))
     {
-	    pnext = p->next;  p->next = NULL; // Zap p->next and p->text
-	    free(p->text);    p->text = NULL; //   to stop accidental reuse
-	    free(p);
-    }
-}
+        // Prompt for command with a single write(), after anything the
+        // last command left in stdout's buffer
+        fflush(stdout);
+        int promptLen = snprintf(prompt, sizeof(prompt), "(%d)$ ", nCmd);
+        while(write(STDOUT_FILENO, prompt, promptLen) < 0 && errno == EINTR);
 
-// Print in in-order command data structure rooted at *C at depth LEVEL
-void dumpTree(CMD* c, int level)
-{
-    if(!c)
-    {
-	    return;
-    }
+        line = NULL;
+        cmd = NULL;
+        if(readingAhead) // Take the next line parsed by the read-ahead thread
+        {
+            if(!nextReadAhead(&line, &lineNum, &list, &cmd))
+            {
+                break; // Break on end of file
+            }
+        }
+        else
+        {
+            if(streaming) // Lex tokens straight from stdin
+            {
+                list = tokenizeStream(stdin, &atEOF);
+                if(atEOF && list == NULL)
+                {
+                    break; // Break on end of file
+                }
+            }
+            else
+            {
+                // Read line
+                lineNum = getLineCount() + 1;
+                if((line = getJoinedLine(stdin)) == NULL)
+                {
+                    break; // Break on end of file
+                }
+
+                // Expand a history reference and add the line to the history
+                if(keepHistory)
+                {
+                    line = historyLine(line);
+                }
+
+                // Lex line into tokens
+                list = line ? tokenize(line) : NULL;
+            }
 
-    dumpTree(c->left, level+1);
+            if(list != NULL)
+            {
+                cmd = parse(list); // Parse tokens into a command
+            }
+        }
 
-    printf("CMD (Depth = %d):  ", level);
+        if(cmd != NULL) // Parsed command?
+        {
+            profileBegin(lineNum, line);
+            recordBegin();
+            replayBegin();
+            status = process(cmd); // Execute command
+            replayEnd(status);
+            recordEnd(status);
+            profileEnd();
+            freeCMD(cmd); // Free associated storage
+            nCmd++;       // Adjust prompt
+        }
 
-    switch(c->type)
-    {
-        case SIMPLE:
-            printf("SIMPLE");
-            dumpArgs(c);
-            dumpRedirect(c);
-            break;
-
-        case SUBCMD:
-            printf("SUBCMD");
-            dumpRedirect(c);
-            break;
-
-        case PIPE:
-            printf("PIPE");
-            break;
-
-        case PIPE_ERR:
-            printf("PIPE_ERR");
-            break;
-
-        case SEP_AND:
-            printf("SEP_AND");
-            break;
-
-        case SEP_OR:
-            printf("SEP_OR");;
-            break;
-
-        case SEP_END:
-            printf("SEP_END");
-            break;
-
-        case SEP_BG:
-            printf("SEP_BG");
-            break;
-
-        default:
-            printf("NONE");
-            break;
+        freeList(list); // Free token list
+        if(readingAhead)
+        {
+            readAheadDone();
+        }
     }
-    printf("\n");
 
-    dumpTree(c->right, level+1);
+    finishRequest(status);
+    return EXIT_SUCCESS;
 }
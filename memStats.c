@@ -0,0 +1,195 @@
+/*
+ * File:   memStats.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the per-subsystem allocation counters described in
+ * memStats.h. Each counted block is preceded by a header recording its size
+ * and the subsystem that allocated it, so a block freed by another subsystem
+ * is still credited to the one that allocated it. The counters are updated
+ * with atomic operations, since the read-ahead thread allocates too.
+ */
+
+#define _GNU_SOURCE
+#define MEM_STATS_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "memStats.h"
+
+#ifdef MEM_STATS
+
+// header placed before each counted block; the union keeps the block that
+// follows it aligned for any type
+typedef union memHeader {
+    struct {
+        size_t size;   // size requested by the caller
+        int subsystem; // subsystem charged for the block
+    } info;
+    long double alignLongDouble;
+    long long alignLongLong;
+    void* alignPtr;
+} memHeader;
+
+typedef struct {
+    unsigned long allocs;   // number of malloc/strdup calls
+    unsigned long reallocs; // number of realloc calls
+    unsigned long frees;    // number of blocks freed
+    unsigned long long bytes; // total bytes requested
+    size_t live;            // bytes currently allocated
+    size_t peak;            // maximum of live
+} memCounter;
+
+static memCounter counters[MEM_NSUBSYSTEMS];
+static size_t totalLive = 0, totalPeak = 0;
+
+static const char* subsystemNames[MEM_NSUBSYSTEMS] = {
+    "getLine", "tokenize", "parse", "here-doc", "builtins", "process"
+};
+
+// Adds n to the counter at p
+#define COUNT(p, n) __atomic_fetch_add(&(p), (n), __ATOMIC_RELAXED)
+
+// Raises the peak at *peak to live if live is greater
+static void raisePeak(size_t* peak, size_t live)
+{
+    size_t old = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while(live > old &&
+          !__atomic_compare_exchange_n(peak, &old, live, true,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+// Adds delta (which may be negative) live bytes to subsystem and updates the
+// peaks
+static void chargeLive(int subsystem, long delta)
+{
+    raisePeak(&counters[subsystem].peak,
+              __atomic_add_fetch(&counters[subsystem].live, (size_t)delta,
+                                 __ATOMIC_RELAXED));
+    raisePeak(&totalPeak,
+              __atomic_add_fetch(&totalLive, (size_t)delta, __ATOMIC_RELAXED));
+}
+
+void* memStatsMalloc(int subsystem, size_t size)
+{
+    memHeader* hdr = malloc(sizeof(memHeader) + size);
+    if(!hdr)
+    {
+        return NULL;
+    }
+
+    hdr->info.size = size;
+    hdr->info.subsystem = subsystem;
+
+    COUNT(counters[subsystem].allocs, 1);
+    COUNT(counters[subsystem].bytes, size);
+    chargeLive(subsystem, size);
+
+    return hdr + 1;
+}
+
+void* memStatsRealloc(int subsystem, void* ptr, size_t size)
+{
+    if(!ptr)
+    {
+        return memStatsMalloc(subsystem, size);
+    }
+
+    memHeader* hdr = (memHeader*)ptr - 1;
+    size_t oldSize = hdr->info.size;
+    int owner = hdr->info.subsystem;
+
+    if(!(hdr = realloc(hdr, sizeof(memHeader) + size)))
+    {
+        return NULL;
+    }
+    hdr->info.size = size;
+
+    COUNT(counters[owner].reallocs, 1);
+    if(size > oldSize)
+    {
+        COUNT(counters[owner].bytes, size - oldSize);
+    }
+    chargeLive(owner, (long)size - (long)oldSize);
+
+    return hdr + 1;
+}
+
+char* memStatsStrdup(int subsystem, const char* str)
+{
+    size_t len = strlen(str) + 1;
+    char* copy = memStatsMalloc(subsystem, len);
+    if(copy)
+    {
+        memcpy(copy, str, len);
+    }
+    return copy;
+}
+
+void memStatsFree(void* ptr)
+{
+    if(!ptr)
+    {
+        return;
+    }
+
+    memHeader* hdr = (memHeader*)ptr - 1;
+    COUNT(counters[hdr->info.subsystem].frees, 1);
+    chargeLive(hdr->info.subsystem, -(long)hdr->info.size);
+    free(hdr);
+}
+
+int dumpMemStats(int fd)
+{
+    dprintf(fd, "%-10s %10s %10s %10s %14s %12s %12s\n",
+            "subsystem", "allocs", "reallocs", "frees", "bytes", "live",
+            "peak");
+
+    memCounter total = {0, 0, 0, 0, 0, 0};
+    for(int i = 0; i < MEM_NSUBSYSTEMS; i++)
+    {
+        memCounter* c = &counters[i];
+        dprintf(fd, "%-10s %10lu %10lu %10lu %14llu %12zu %12zu\n",
+                subsystemNames[i], c->allocs, c->reallocs, c->frees, c->bytes,
+                c->live, c->peak);
+
+        total.allocs += c->allocs;
+        total.reallocs += c->reallocs;
+        total.frees += c->frees;
+        total.bytes += c->bytes;
+    }
+    dprintf(fd, "%-10s %10lu %10lu %10lu %14llu %12zu %12zu\n",
+            "total", total.allocs, total.reallocs, total.frees, total.bytes,
+            totalLive, totalPeak);
+
+    return 0;
+}
+
+void resetMemStats(void)
+{
+    for(int i = 0; i < MEM_NSUBSYSTEMS; i++)
+    {
+        counters[i].allocs = 0;
+        counters[i].reallocs = 0;
+        counters[i].frees = 0;
+        counters[i].bytes = 0;
+        counters[i].peak = counters[i].live;
+    }
+    totalPeak = totalLive;
+}
+
+#else
+
+int dumpMemStats(int fd)
+{
+    fprintf(stderr, "memstats: eggshell was not compiled with MEMSTATS=1\n");
+    return 1;
+}
+
+void resetMemStats(void)
+{
+}
+
+#endif
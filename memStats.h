@@ -0,0 +1,53 @@
+/*
+ * File:   memStats.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Per-subsystem allocation counters. When compiled with MEM_STATS (see
+ * MEMSTATS=1 in the Makefile), including this header routes malloc, realloc,
+ * strdup, and free through counting wrappers. Allocations are charged to the
+ * subsystem named by MEM_SUBSYSTEM, which each file defines before including
+ * this header. This header must be included after all system headers.
+ */
+
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// Subsystems that allocations can be charged to
+enum {
+    MEM_GETLINE,
+    MEM_TOKENIZE,
+    MEM_PARSE,
+    MEM_HEREDOC,
+    MEM_BUILTIN,
+    MEM_PROCESS,
+    MEM_NSUBSYSTEMS
+};
+
+#if defined(MEM_STATS) && !defined(MEM_STATS_IMPL)
+
+void* memStatsMalloc(int subsystem, size_t size);
+void* memStatsRealloc(int subsystem, void* ptr, size_t size);
+char* memStatsStrdup(int subsystem, const char* str);
+void  memStatsFree(void* ptr);
+
+#define malloc(n)     memStatsMalloc(MEM_SUBSYSTEM, (n))
+#define realloc(p, n) memStatsRealloc(MEM_SUBSYSTEM, (p), (n))
+#define strdup(s)     memStatsStrdup(MEM_SUBSYSTEM, (s))
+#define free(p)       memStatsFree(p)
+
+#endif
+
+// Prints a table of the allocation counters for each subsystem to fd. Returns
+// 0 if successful, 1 if eggshell was not compiled with MEM_STATS.
+int dumpMemStats(int fd);
+
+// Resets the cumulative counters (but not the live byte counts) of every
+// subsystem
+void resetMemStats(void);
+
+#endif
@@ -0,0 +1,598 @@
+/*
+ * File:   outputCache.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the cache built-in described in outputCache.h. An entry
+ * is a header followed by the recorded standard output and standard error.
+ * Entries are written to a temporary file that is then renamed into place, so
+ * a shell replaying an entry never sees one half written.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "outputCache.h"
+#include "process.h"
+#include "cacheDir.h"
+#include "fullIO.h"
+
+#define MEM_SUBSYSTEM MEM_BUILTIN
+#include "memStats.h"
+
+#define USAGE "cache: Usage: cache [--inputs file,...] [--env var,...] " \
+              "[--metadata] [--] command [arg ...]\n" \
+              "       cache --stats\n"
+
+// name of the cache directory under $HOME/.eggshell
+#define OUTPUT_CACHE_NAME "outputs"
+
+// defaults for EGGSHELL_CACHE_SIZE (bytes) and EGGSHELL_CACHE_AGE (days)
+#define CACHE_DEFAULT_SIZE (64ULL << 20)
+#define CACHE_DEFAULT_AGE (30)
+
+#define OUTPUT_MAGIC "EGGOUT1"
+
+// a hash identifying a command, in two independent halves
+typedef struct {
+    unsigned long long h[2];
+} commandKey;
+
+typedef struct {
+    char magic[8];                 // OUTPUT_MAGIC
+    commandKey key;                // the command's hash
+    long long status;              // its exit status
+    unsigned long long outLen;     // the length of its standard output
+    unsigned long long errLen;     //   and standard error
+    unsigned long long runNsec;    // how long it ran
+} outputHeader;
+
+// name of the store's statistics file, which eviction leaves alone
+#define STATS_NAME ".stats"
+
+// the lookups in the store by every shell, and the time the hits saved,
+// updated atomically in a shared mapping of the statistics file
+typedef struct {
+    unsigned long long hits;
+    unsigned long long misses;
+    long long savedNsec;
+} outputStats;
+
+// bytes of piped input read at a time
+#define INPUT_CHUNK_SIZE (16384)
+
+// the option values of a cache command
+typedef struct {
+    char* inputs;    // comma-separated files, or NULL
+    char* env;       // comma-separated variable names, or NULL
+    bool metadata;   // identify files by their metadata?
+} cacheOptions;
+
+// Adds the len bytes at data to key
+static void addToKey(commandKey* key, const void* data, size_t len)
+{
+    key->h[0] = cacheHash(data, len, key->h[0]);
+    key->h[1] = cacheHash(data, len, ~key->h[1]);
+}
+
+// Adds the string str, with its terminator, to key
+static void addString(commandKey* key, const char* str)
+{
+    addToKey(key, str, strlen(str) + 1);
+}
+
+// Adds the contents of the file fd, whose status is st, to key
+static void addContents(commandKey* key, int fd, const struct stat* st)
+{
+    void* map = (st->st_size > 0) ?
+                mmap(NULL, st->st_size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    if(map == MAP_FAILED)
+    {
+        addString(key, "(unreadable)");
+    }
+    else
+    {
+        addToKey(key, map, map ? st->st_size : 0);
+    }
+    if(map && map != MAP_FAILED)
+    {
+        munmap(map, st->st_size);
+    }
+}
+
+// Adds the file path to key: its contents, or its identity if metadata is
+// true, or a mark that it's missing
+static void addFile(commandKey* key, const char* path, bool metadata)
+{
+    addString(key, path);
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) < 0)
+    {
+        addString(key, "(missing)");
+    }
+    else if(metadata)
+    {
+        unsigned long long id[5] = { st.st_dev, st.st_ino, st.st_size,
+                                     st.st_mtim.tv_sec, st.st_mtim.tv_nsec };
+        addToKey(key, id, sizeof(id));
+    }
+    else
+    {
+        addContents(key, fd, &st);
+    }
+
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+// Adds each item of the comma-separated list to key with add
+static void addList(commandKey* key, const char* list, bool metadata,
+                    void (*add)(commandKey*, const char*, bool))
+{
+    char* copy = strdup(list);
+    for(char* item = strtok(copy, ","); item; item = strtok(NULL, ","))
+    {
+        add(key, item, metadata);
+    }
+    free(copy);
+}
+
+// Adds the variable name and its value, or a mark that it's unset, to key
+static void addVar(commandKey* key, const char* name, bool metadata)
+{
+    const char* value = getenv(name);
+    addString(key, name);
+    addString(key, value ? value : "(unset)");
+}
+
+// Returns the key of the command argv as cmd runs it, with the options opts,
+// and with the piped input read into the file in if it isn't -1
+static commandKey makeKey(CMD* cmd, char** argv, const cacheOptions* opts,
+                          int in)
+{
+    commandKey key = { { 0, 0 } };
+    for(char** arg = argv; *arg; arg++)
+    {
+        addString(&key, *arg);
+    }
+
+    char cwd[PATH_MAX];
+    addString(&key, getcwd(cwd, sizeof(cwd)) ? cwd : "(unknown)");
+
+    addString(&key, "--env");
+    if(opts->env)
+    {
+        addList(&key, opts->env, false, addVar);
+    }
+    addString(&key, "--inputs");
+    if(opts->inputs)
+    {
+        addList(&key, opts->inputs, opts->metadata, addFile);
+    }
+
+    addString(&key, "<");
+    if(cmd->fromType == RED_IN)
+    {
+        addFile(&key, cmd->fromFile, opts->metadata);
+    }
+    else if(cmd->fromType == RED_HERE)
+    {
+        addString(&key, cmd->fromFile);
+    }
+    else if(in >= 0)
+    {
+        struct stat st;
+        if(fstat(in, &st) == 0)
+        {
+            addContents(&key, in, &st);
+        }
+    }
+    return key;
+}
+
+// Returns the malloc'd path of the entry for key, or NULL if the cache is
+// disabled or its directory can't be created
+static char* entryPath(const commandKey* key)
+{
+    if(envNumber("EGGSHELL_CACHE_SIZE", CACHE_DEFAULT_SIZE) == 0)
+    {
+        return NULL;
+    }
+
+    char* dir = cacheDir(OUTPUT_CACHE_NAME);
+    if(!dir)
+    {
+        return NULL;
+    }
+
+    size_t len = strlen(dir) + 34;
+    char* path = malloc(len);
+    snprintf(path, len, "%s/%016llx%016llx", dir, key->h[0], key->h[1]);
+    free(dir);
+    return path;
+}
+
+// Returns the current time in seconds
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// Returns the store's statistics, mapping the file that holds them the first
+// time, or NULL if it can't be mapped. Children forked later share the
+// mapping.
+static outputStats* storeStats(void)
+{
+    static outputStats* stats = NULL;
+    if(stats)
+    {
+        return stats;
+    }
+
+    char* dir = cacheDir(OUTPUT_CACHE_NAME);
+    if(!dir)
+    {
+        return NULL;
+    }
+    size_t len = strlen(dir) + strlen(STATS_NAME) + 2;
+    char* path = malloc(len);
+    snprintf(path, len, "%s/%s", dir, STATS_NAME);
+    free(dir);
+
+    // a new file is all zeros, which are empty statistics
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    struct stat st;
+    free(path);
+    if(fd < 0 || fstat(fd, &st) < 0 ||
+       ((size_t)st.st_size < sizeof(outputStats) &&
+        ftruncate(fd, sizeof(outputStats)) < 0))
+    {
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+        return NULL;
+    }
+
+    void* map = mmap(NULL, sizeof(outputStats), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+    close(fd);
+    stats = (map == MAP_FAILED) ? NULL : map;
+    return stats;
+}
+
+// Counts a lookup in the store's statistics: a hit that saved savedNsec, or a
+// miss
+static void countLookup(bool hit, long long savedNsec)
+{
+    outputStats* stats = storeStats();
+    if(!stats)
+    {
+        return;
+    }
+
+    if(hit)
+    {
+        __atomic_fetch_add(&stats->hits, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stats->savedNsec, savedNsec, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        __atomic_fetch_add(&stats->misses, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Replays the entry at path for key to out and standard error, setting
+// *status to the exit status recorded in it. Returns false if there is no
+// such entry.
+static bool replay(const char* path, const commandKey* key, int out,
+                   int* status)
+{
+    double start = now();
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) < 0 ||
+       (size_t)st.st_size < sizeof(outputHeader))
+    {
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+        return false;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    const outputHeader* h = map;
+    const char* text = (const char*)(h + 1);
+    bool valid = memcmp(h->magic, OUTPUT_MAGIC, sizeof(h->magic)) == 0 &&
+                 memcmp(&h->key, key, sizeof(commandKey)) == 0 &&
+                 sizeof(outputHeader) + h->outLen + h->errLen ==
+                 (size_t)st.st_size;
+    if(valid)
+    {
+        writeAll(out, text, h->outLen);
+        writeAll(STDERR_FILENO, text + h->outLen, h->errLen);
+        *status = h->status;
+        futimens(fd, NULL); // mark the entry used for eviction
+
+        countLookup(true, h->runNsec - (long long)((now() - start) * 1e9));
+    }
+
+    munmap(map, st.st_size);
+    close(fd);
+    return valid;
+}
+
+// Maps the whole of the file fd, setting *len to its length. Returns the
+// mapping, or NULL if it is empty or can't be mapped.
+static void* mapAll(int fd, size_t* len)
+{
+    struct stat st;
+    *len = 0;
+    if(fstat(fd, &st) < 0 || st.st_size == 0)
+    {
+        return NULL;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map == MAP_FAILED)
+    {
+        return NULL;
+    }
+    *len = st.st_size;
+    return map;
+}
+
+// Records h, with the output outLen bytes at outText and error at errText, in
+// the entry at path, then evicts what no longer fits
+static void record(const char* path, outputHeader* h, const void* outText,
+                   const void* errText)
+{
+    unsigned long long maxSize = envNumber("EGGSHELL_CACHE_SIZE",
+                                           CACHE_DEFAULT_SIZE);
+    if(sizeof(outputHeader) + h->outLen + h->errLen > maxSize)
+    {
+        return;
+    }
+
+    size_t tmpLen = strlen(path) + 32;
+    char* tmp = malloc(tmpLen);
+    snprintf(tmp, tmpLen, "%s.%ld.tmp", path, (long)getpid());
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if(fd >= 0)
+    {
+        bool written = writeAll(fd, h, sizeof(outputHeader)) &&
+                       writeAll(fd, outText, h->outLen) &&
+                       writeAll(fd, errText, h->errLen);
+        if(close(fd) < 0 || !written || rename(tmp, path) < 0)
+        {
+            unlink(tmp);
+        }
+    }
+
+    char* dir = cacheDir(OUTPUT_CACHE_NAME);
+    if(dir)
+    {
+        evictCache(dir, maxSize,
+                   envNumber("EGGSHELL_CACHE_AGE", CACHE_DEFAULT_AGE) * 86400);
+        free(dir);
+    }
+    free(tmp);
+}
+
+// Runs the command argv as cmd would, with its standard input from in,
+// capturing its output, which is then written to out and standard error and
+// recorded in the entry at path for key (if path isn't NULL). Returns its exit
+// status.
+static int runAndRecord(CMD* cmd, char** argv, int argc, int in, int out,
+                        const char* path, const commandKey* key)
+{
+    CMD run = *cmd;
+    run.argc = argc;
+    run.argv = argv;
+    run.toType = NONE;
+    run.toFile = NULL;
+    run.subst = NULL;
+    run.expand = false;
+
+    int outFd = memfd_create("cache-out", MFD_CLOEXEC);
+    int errFd = memfd_create("cache-err", MFD_CLOEXEC);
+    if(outFd < 0 || errFd < 0)
+    {
+        // run it uncaptured
+        outFd = (outFd >= 0) ? (close(outFd), -1) : -1;
+        errFd = (errFd >= 0) ? (close(errFd), -1) : -1;
+        path = NULL;
+    }
+
+    double start = now();
+    pid_t pid = spawnSimple(&run, in, (outFd >= 0) ? outFd : out,
+                            (errFd >= 0) ? errFd : STDERR_FILENO);
+    int status = W_EXITCODE(errno, 0);
+    if(pid > 0)
+    {
+        signal(SIGINT, SIG_IGN);
+        while(waitpid(pid, &status, 0) < 0 && errno == EINTR);
+        signal(SIGINT, SIG_DFL);
+    }
+    double elapsed = now() - start;
+
+    if(outFd >= 0)
+    {
+        size_t outLen, errLen;
+        void* outText = mapAll(outFd, &outLen);
+        void* errText = mapAll(errFd, &errLen);
+        writeAll(out, outText, outLen);
+        writeAll(STDERR_FILENO, errText, errLen);
+
+        if(path && pid > 0 && WIFEXITED(status))
+        {
+            outputHeader h;
+            memset(&h, 0, sizeof(h));
+            memcpy(h.magic, OUTPUT_MAGIC, sizeof(h.magic));
+            h.key = *key;
+            h.status = GET_STATUS(status);
+            h.outLen = outLen;
+            h.errLen = errLen;
+            h.runNsec = elapsed * 1e9;
+            record(path, &h, outText, errText);
+        }
+
+        if(outText)
+        {
+            munmap(outText, outLen);
+        }
+        if(errText)
+        {
+            munmap(errText, errLen);
+        }
+        close(outFd);
+        close(errFd);
+    }
+
+    countLookup(false, 0);
+    return GET_STATUS(status);
+}
+
+// Prints the lookups in the store to out
+static void printStats(int out)
+{
+    outputStats* stats = storeStats();
+    outputStats none = { 0, 0, 0 };
+    outputStats s = stats ? *stats : none;
+    unsigned long long lookups = s.hits + s.misses;
+    dprintf(out, "cache: %llu hits, %llu misses (%.1f%% hit ratio), %.3f s "
+            "saved\n", s.hits, s.misses,
+            lookups ? 100.0 * s.hits / lookups : 0.0, s.savedNsec / 1e9);
+}
+
+// Returns true if fd is a pipe or socket
+static bool isPipe(int fd)
+{
+    struct stat st;
+    return fstat(fd, &st) == 0 &&
+           (S_ISFIFO(st.st_mode) || S_ISSOCK(st.st_mode));
+}
+
+// Reads all of the pipe fd into a new file. Returns the file, positioned at
+// its start, or -1 with errno set.
+static int readPipe(int fd)
+{
+    int file = memfd_create("cache-in", MFD_CLOEXEC);
+    if(file < 0)
+    {
+        return -1;
+    }
+
+    char buf[INPUT_CHUNK_SIZE];
+    for( ; ; )
+    {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if(n == 0)
+        {
+            break;
+        }
+        else if((n < 0 && errno != EINTR) || (n > 0 && !writeAll(file, buf, n)))
+        {
+            close(file);
+            return -1;
+        }
+    }
+
+    lseek(file, 0, SEEK_SET);
+    return file;
+}
+
+int cacheCommand(CMD* cmd, int out)
+{
+    cacheOptions opts = { NULL, NULL, false };
+
+    int i = 1;
+    for( ; cmd->argv[i] && strncmp(cmd->argv[i], "--", 2) == 0; i++)
+    {
+        char* opt = cmd->argv[i];
+        if(strcmp(opt, "--") == 0)
+        {
+            i++;
+            break;
+        }
+        else if(strcmp(opt, "--stats") == 0 && cmd->argc == 2)
+        {
+            printStats(out);
+            return 0;
+        }
+        else if(strcmp(opt, "--metadata") == 0)
+        {
+            opts.metadata = true;
+        }
+        else if(strcmp(opt, "--inputs") == 0 && cmd->argv[i + 1])
+        {
+            opts.inputs = cmd->argv[++i];
+        }
+        else if(strcmp(opt, "--env") == 0 && cmd->argv[i + 1])
+        {
+            opts.env = cmd->argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, USAGE);
+            return 1;
+        }
+    }
+    if(!cmd->argv[i])
+    {
+        fprintf(stderr, USAGE);
+        return 1;
+    }
+
+    // piped input is read whole first, so that it can be part of the key and
+    // still be fed to the command
+    int in = -1;
+    if(cmd->fromType == NONE && isPipe(STDIN_FILENO) &&
+       (in = readPipe(STDIN_FILENO)) < 0)
+    {
+        perror("cache");
+        return 1;
+    }
+
+    char** argv = cmd->argv + i;
+    commandKey key = makeKey(cmd, argv, &opts, in);
+    char* path = entryPath(&key);
+
+    int status;
+    if(!path || !replay(path, &key, out, &status))
+    {
+        status = runAndRecord(cmd, argv, cmd->argc - i,
+                              (in >= 0) ? in : STDIN_FILENO, out, path, &key);
+    }
+    if(in >= 0)
+    {
+        close(in);
+    }
+    free(path);
+    return status;
+}
@@ -0,0 +1,42 @@
+/*
+ * File:   outputCache.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for the cache built-in, which memoizes the output of commands
+ * that always give the same output for the same inputs:
+ *
+ *   cache [--inputs file,...] [--env var,...] [--metadata] [--] command
+ *         [arg ...]
+ *   cache --stats
+ *
+ * A command is identified by a hash of its arguments, the working directory,
+ * the values of the environment variables named by --env, and the contents of
+ * the files named by --inputs and of its standard input, if that is
+ * redirected from a file or a here document or is a pipe (which is read whole
+ * into a file first, and fed to the command from there); a terminal isn't
+ * part of the key. With --metadata, files are
+ * identified by their device, inode, size, and modification time instead of
+ * their contents. If $HOME/.eggshell/outputs has an entry named for the hash,
+ * the standard output, standard error, and exit status recorded in it are
+ * replayed instead of running the command. Otherwise the command is run with
+ * its output captured, which is then written out and, if the command exited
+ * rather than being killed, recorded. Entries are limited, and evicted, as
+ * EGGSHELL_CACHE_SIZE and EGGSHELL_CACHE_AGE say (see scriptCache.h).
+ *
+ * cache --stats prints how many lookups hit and missed, and how much time
+ * the hits saved, counted in the store's .stats file by every shell and
+ * pipeline stage that used it.
+ */
+
+#ifndef OUTPUTCACHE_H
+#define OUTPUTCACHE_H
+
+#include "parse.h"
+
+// Executes the cache command cmd, writing the output of the command it caches
+// to out, and returns the exit status
+int cacheCommand(CMD* cmd, int out);
+
+#endif
@@ -1,6 +1,7 @@
 /* 
  * File:   parse.c
  * Author: Alexander Schurman (alexander.schurman@gmail.com)
+ * Modified by: agent (agent@local)
  *
  * Created on October 27, 2012
  * 
@@ -18,6 +19,9 @@
 #include "getLine.h"
 #include "strBuffer.h"
 
+#define MEM_SUBSYSTEM MEM_PARSE
+#include "memStats.h"
+
 /*******************************************************************************
  ****************************** Redirection ************************************
  ******************************************************************************/
@@ -50,6 +54,18 @@ void freeRedirection(redirection* red)
     }
 }
 
+// allocations made while reading here documents are charged to MEM_HEREDOC
+#undef MEM_SUBSYSTEM
+#define MEM_SUBSYSTEM MEM_HEREDOC
+
+// where here documents look up their variables, if not with getenv()
+static const char* (*varLookup)(const char* name) = NULL;
+
+void setParseVarLookup(const char* (*lookup)(const char* name))
+{
+    varLookup = lookup;
+}
+
 // Steps through line and appends each char (including the final \n) to doc,
 // respecting escapes and environment variables. NOTE: line must have a '\n'
 // directly before the terminating '\0' or BAD things will happen.
@@ -93,10 +109,11 @@ void readHereDocLine(char* line, strBuffer* doc)
                     strBufferAppend(var, *c);
                 }
 
-                char* value = getenv(var->str);
+                const char* value = varLookup ? varLookup(var->str) :
+                                                getenv(var->str);
                 if(value)
                 {
-                    for(char* p = value; *p != '\0'; p++)
+                    for(const char* p = value; *p != '\0'; p++)
                     {
                         strBufferAppend(doc, *p);
                     }
@@ -173,6 +190,9 @@ bool readHereDocument(token** tok, redirection** red)
     return true;
 }
 
+#undef MEM_SUBSYSTEM
+#define MEM_SUBSYSTEM MEM_PARSE
+
 #define IS_IN_REDIRECT(x)  ((x) == RED_IN       || (x) == RED_HERE)
 
 #define IS_OUT_REDIRECT(x) ((x) == RED_OUT      || (x) == RED_OUT_C     || \
@@ -182,6 +202,20 @@ bool readHereDocument(token** tok, redirection** red)
 
 #define IS_REDIRECT(x)     (IS_IN_REDIRECT(x)   || IS_OUT_REDIRECT(x))
 
+// Removes the GLOB_MARKs from text, which isn't expanded
+void stripGlobMarks(char* text)
+{
+    char* q = text;
+    for(char* p = text; *p; p++)
+    {
+        if(*p != GLOB_MARK)
+        {
+            *q++ = *p;
+        }
+    }
+    *q = '\0';
+}
+
 // Checks the beginning of tok for redirection symbols and updates the stdin
 // redirection, redIn, and stdout redirection, redOut, based on tok. Updates
 // tok to point to the token following the last one relevant to redirection.
@@ -208,8 +242,14 @@ bool checkRedirection(token** tok, redirection** redIn, redirection** redOut)
                 {
                     return false;
                 }
-                else if((*redIn)->type == RED_IN)
+                
+                stripGlobMarks((*tok)->text);
+                if((*redIn)->type == RED_IN)
                 {
+                    if(strpbrk((*tok)->text, SUBST_MARKS))
+                    {
+                        return false; // file names aren't substituted
+                    }
                     (*redIn)->file = strdup((*tok)->text);
                     *tok = (*tok)->next; // remove the SIMPLE containing
                                          // the redirection's file field
@@ -233,12 +273,14 @@ bool checkRedirection(token** tok, redirection** redIn, redirection** redOut)
                 
                 *tok = (*tok)->next; // remove the output redirection symbol
                 
-                if(*tok == NULL || (*tok)->type != SIMPLE)
+                if(*tok == NULL || (*tok)->type != SIMPLE ||
+                   strpbrk((*tok)->text, SUBST_MARKS))
                 {
                     return false;
                 }
                 else
                 {
+                    stripGlobMarks((*tok)->text);
                     (*redOut)->file = strdup((*tok)->text);
                     *tok = (*tok)->next; // remove the SIMPLE containing the
                                          // redirection's file field
@@ -313,6 +355,10 @@ bool checkMultipleRedirection(CMD* root)
  * token following the last token parsed.
  * If tok is invalid, these functions return NULL and put NULL in cmdOut. */
 
+// parseCommand is called by parseSimple and parseStage, so this function
+// prototype is here
+token* parseCommand(token* tok, CMD** cmdOut);
+
 // See comment at the top of the "parseSomething Functions" section. In addition
 // to that description, parseSimple takes in info about redirections from before
 // the first SIMPLE token of this <simple>, and also adds info about
@@ -331,9 +377,12 @@ token* parseSimple(token* tok,
     CMD* simple = mallocCMD();
     simple->type = SIMPLE;
     
-    while(tok != NULL && (tok->type == SIMPLE || IS_REDIRECT(tok->type)))
+    CMD** substTail = &simple->subst; // where the next substitution goes
+    
+    while(tok != NULL && (tok->type == SIMPLE || IS_REDIRECT(tok->type) ||
+                          ISSUBST(tok->type)))
     {
-        if(tok->type == SIMPLE)
+        if(tok->type == SIMPLE || ISSUBST(tok->type))
         {
             // add arg to simple
             simple->argc++;
@@ -341,9 +390,35 @@ token* parseSimple(token* tok,
             simple->argv = realloc(simple->argv, sizeof(char*) * (argc + 1));
             simple->argv[argc] = NULL;
             simple->argv[argc - 1] = strdup(tok->text);
-            
+            if(strpbrk(tok->text, SUBST_MARKS) || strchr(tok->text, GLOB_MARK))
+            {
+                simple->expand = true; // expand when executed
+            }
+        }
+        
+        if(tok->type == SIMPLE)
+        {
             tok = tok->next; // move past the SIMPLE just read
         }
+        else if(ISSUBST(tok->type))
+        {
+            // the arg is replaced by the pipe to or from the command when
+            // simple is executed
+            CMD* subst = mallocCMD();
+            subst->type = tok->type;
+            subst->argc = simple->argc - 1;
+            *substTail = subst;
+            substTail = &subst->right;
+            
+            tok = parseCommand(tok->next, &subst->left);
+            if(subst->left == NULL || tok == NULL || tok->type != PAR_RIGHT)
+            {
+                freeCMD(simple);
+                *cmdOut = NULL;
+                return NULL;
+            }
+            tok = tok->next; // remove PAR_RIGHT
+        }
         else if(!checkRedirection(&tok, redIn, redOut))
         {
             // invalid redirection
@@ -357,9 +432,6 @@ token* parseSimple(token* tok,
     return tok;
 }
 
-// parseCommand is called by parseStage, so this function prototype is here
-token* parseCommand(token* tok, CMD** cmdOut);
-
 // See comment at the top of the "parseSomething Functions" section
 token* parseStage(token* tok, CMD** cmdOut)
 {
@@ -593,7 +665,7 @@ CMD* parse(token* tok)
     if(tok != NULL || parsed == NULL || !checkMultipleRedirection(parsed))
     {
         if(parsed) freeCMD(parsed);
-        fprintf(stderr, "Error in parsing tokens.\n");
+        parseError("Error in parsing tokens.\n");
         return NULL;
     }
     else
@@ -601,3 +673,22 @@ CMD* parse(token* tok)
         return parsed;
     }
 }
+
+static void (*errorHandler)(const char* msg) = NULL;
+
+void parseError(const char* msg)
+{
+    if(errorHandler)
+    {
+        errorHandler(msg);
+    }
+    else
+    {
+        fputs(msg, stderr);
+    }
+}
+
+void setParseErrorHandler(void (*handler)(const char* msg))
+{
+    errorHandler = handler;
+}
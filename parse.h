@@ -7,6 +7,9 @@
 #ifndef PARSE_H
 #define PARSE_H
 
+#include <stdio.h>
+#include <stdbool.h>
+
 
 // A token is
 //
@@ -17,13 +20,34 @@
 //
 // (3) a command terminator (;, &, &&, or ||);
 //
-// (4) a left or right parenthesis (used to group commands).
+// (4) a left or right parenthesis (used to group commands); or
+//
+// (5) the start of a process substitution (<( or >(), which is ended by a
+//     right parenthesis.
 
 
 // String containing all metacharacters that terminate SIMPLE tokens
 #define METACHAR "<>;&|()"
 
 
+// A command substitution `<command>` in a SIMPLE token is stored in its text
+// as the <command>, unchanged, between a pair of SUBST_WORDS; or, if it was
+// within double quotes, SUBST_QUOTED.  When the command is executed, it is
+// replaced by the output of the <command>, split into words or kept as part
+// of the one argument, respectively.
+#define SUBST_WORDS  '\001'
+#define SUBST_QUOTED '\002'
+#define SUBST_MARKS  "\001\002"
+
+
+// Each unquoted glob character (*, ?, [, or {) in the text of a SIMPLE token,
+// other than the ? of $?, is preceded by GLOB_MARK, so that the argument can
+// be matched against file names (and its braces expanded) when the command is
+// executed.  Redirections aren't expanded, and their marks are removed.
+#define GLOB_CHARS   "*?[{"
+#define GLOB_MARK    '\003'
+
+
 // A token list is a headless linked list of typed tokens.  All storage is
 // allocated by malloc() / realloc().  The token type is specified by the
 // symbolic constants defined below.
@@ -42,6 +66,15 @@ typedef struct token {          // Struct for each token in linked list
 token *tokenize (char *line);
 
 
+// Read the next command line from FP, decoding and lexing it in a single pass
+// without building the line, and return its tokens as tokenize() would.  An
+// unquoted backslash-newline continues the line.  The input is consumed up to
+// and including the newline that ends the line, so a here document can be
+// read next.  *ATEOF is set to true if FP was already at end of file.
+
+token *tokenizeStream (FILE *fp, bool *atEOF);
+
+
 // Print out the token list
 void dumpList (token *list);
 
@@ -83,6 +116,9 @@ enum {
       PAR_LEFT,         // (
       PAR_RIGHT,        // )
 
+      PROC_IN,          // <(
+      PROC_OUT,         // >(
+
    // Token types used by parse() et al.
 
       NONE,             // Nontoken: Did not find a token
@@ -101,6 +137,8 @@ enum {
 		      (x) == RED_ERR_APP  || (x) == RED_ERR_APP_C || \
 		      (x) == PIPE_ERR)
 
+#define ISSUBST(x)   ((x) == PROC_IN      || (x) == PROC_OUT)
+
 #define ISCLOBBER(x) ((x) == RED_OUT_C    || (x) == RED_OUT_APP_C || \
 		      (x) == RED_ERR_C    || (x) == RED_ERR_APP_C)
 
@@ -117,10 +155,10 @@ enum {
 //                         / <and-or> & <command> / <and-or> &
 //
 // where a <simple> is a single command with arguments and I/O redirection but
-// no |, &, ;, &&, ||, (, or ).  Note that I/O redirection is associated with a
-// <stage> (i.e., a <simple> or subcommand), but not with a <pipeline> (input/
-// output redirection for the first/last stage is associated with the stage,
-// not the pipeline).
+// no |, &, ;, &&, ||, (, or ) (except in process substitutions).  Note that
+// I/O redirection is associated with a <stage> (i.e., a <simple> or
+// subcommand), but not with a <pipeline> (input/output redirection for the
+// first/last stage is associated with the stage, not the pipeline).
 //
 // A command is represented by a tree of CMD structs containing its <simple>
 // commands and the "operators" |, |&, &&, ||, ;, &, and SUBCMD.  The tree
@@ -129,9 +167,14 @@ enum {
 // grammar above.
 //
 // The tree for a <simple> is a single struct of type SIMPLE that specifies its
-// arguments (argc, argv[]); and whether and where to redirect its standard
+// arguments (argc, argv[]) and whether any contain command substitutions or
+// glob characters (expand); and whether and where to redirect its standard
 // input (fromType, fromFile) or its standard output (toType, toFile).  The
-// left and right children are NULL.
+// left and right children are NULL.  Each process substitution <(<command>) or
+// >(<command>) among its arguments is a CMD struct of type PROC_IN or PROC_OUT
+// in the list hanging off of subst, whose argc is the index of the argument it
+// replaces, whose left child is the tree representing the <command>, and whose
+// right child is the next process substitution or NULL.
 //
 // The tree for a <stage> is either the tree for a <simple> or a CMD struct
 // of type SUBCMD (which may have redirection) whose left child is the tree
@@ -216,6 +259,10 @@ typedef struct cmd {
 
   struct cmd *left;     // Left subtree or NULL (default)
   struct cmd *right;    // Right subtree or NULL (default)
+
+  struct cmd *subst;    // Process substitutions of a SIMPLE or NULL (default)
+  bool expand;          // Does argv contain command substitutions or glob
+			//   characters?  (false (default) or true)
 } CMD;
 
 									      
@@ -239,4 +286,19 @@ void dumpTree (CMD *exec, int level);
 // that structure (NULL if errors found).
 CMD *parse (token *tok);
 
+
+// Report the error message MSG found by tokenize() or parse() by passing it
+// to the handler set by setParseErrorHandler(), or printing it to stderr if
+// none is set
+void parseError (const char *msg);
+
+
+// Make parseError() pass messages to HANDLER; NULL restores printing them
+void setParseErrorHandler (void (*handler)(const char *msg));
+
+
+// Make here documents look up the values of their variables with LOOKUP
+// instead of getenv(); NULL restores getenv()
+void setParseVarLookup (const char *(*lookup)(const char *name));
+
 #endif
@@ -0,0 +1,224 @@
+/*
+ * File:   pipeStats.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the pipe sizing and measuring described in pipeStats.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "pipeStats.h"
+#include "cacheDir.h"
+
+#define PIPE_SIZE_VAR  "pipesize"
+#define PIPE_TRACE_VAR "pipetrace"
+#define PIPE_SIZE_AUTO "auto"
+
+// the most a pipe may be grown to without privileges, and its default
+#define PIPE_MAX_PATH "/proc/sys/fs/pipe-max-size"
+#define PIPE_MAX_DEFAULT (1024 * 1024)
+
+// a pipe is grown if its stages blocked at least ADAPT_MIN_BLOCKS times, and
+// at least once for every ADAPT_FILLS bufferfuls that went through it
+#define ADAPT_MIN_BLOCKS (16)
+#define ADAPT_FILLS (4)
+
+// the number of pipes whose sizes are remembered
+#define ADAPT_ENTRIES (64)
+#define ADAPT_KEY_SIZE (128)
+
+// the size learned for the pipe from one command to another
+typedef struct
+{
+    char key[ADAPT_KEY_SIZE]; // "writer|reader"
+    int size;
+} adaptEntry;
+
+static adaptEntry adapted[ADAPT_ENTRIES];
+static int nAdapted = 0, nextAdapted = 0;
+
+// Returns true if $pipesize is auto
+static bool adapting(void)
+{
+    const char* value = getenv(PIPE_SIZE_VAR);
+    return value && strcmp(value, PIPE_SIZE_AUTO) == 0;
+}
+
+bool tracingPipes(void)
+{
+    return getenv(PIPE_TRACE_VAR);
+}
+
+bool measuringPipes(void)
+{
+    return tracingPipes() || adapting();
+}
+
+// Returns the name of a stage for reports and keys: its command's name, or
+// "(...)" for a subcommand
+static const char* stageName(const CMD* stage)
+{
+    return (stage->type == SIMPLE) ? stage->argv[0] : "(...)";
+}
+
+// Returns the entry for the pipe from writer to reader, or NULL
+static adaptEntry* findAdapted(const CMD* writer, const CMD* reader)
+{
+    char key[ADAPT_KEY_SIZE];
+    snprintf(key, sizeof(key), "%s|%s", stageName(writer), stageName(reader));
+    for(int i = 0; i < nAdapted; i++)
+    {
+        if(strcmp(adapted[i].key, key) == 0)
+        {
+            return &adapted[i];
+        }
+    }
+    return NULL;
+}
+
+int pipeSize(const CMD* writer, const CMD* reader)
+{
+    if(!getenv(PIPE_SIZE_VAR))
+    {
+        return 0;
+    }
+    else if(adapting())
+    {
+        adaptEntry* entry = findAdapted(writer, reader);
+        return entry ? entry->size : 0;
+    }
+
+    unsigned long long size = envNumber(PIPE_SIZE_VAR, 0);
+    return (size > INT_MAX) ? INT_MAX : (int)size;
+}
+
+double pipeClock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Sets the bytes read and written by the exited, unreaped process pid in
+// stats, from /proc
+static void readIO(pid_t pid, stageStats* stats)
+{
+    char path[sizeof("/proc//io") + 11];
+    snprintf(path, sizeof(path), "/proc/%d/io", (int)pid);
+
+    FILE* fp = fopen(path, "r");
+    char line[64];
+    while(fp && fgets(line, sizeof(line), fp))
+    {
+        sscanf(line, "rchar: %llu", &stats->rchar);
+        sscanf(line, "wchar: %llu", &stats->wchar);
+    }
+    if(fp)
+    {
+        fclose(fp);
+    }
+}
+
+void reapStage(pid_t pid, int* status, stageStats* stats)
+{
+    siginfo_t info;
+    memset(stats, 0, sizeof(stageStats));
+
+    // read its I/O counts before it's gone
+    while(waitid(P_PID, pid, &info, WEXITED | WNOWAIT) < 0 && errno == EINTR);
+    readIO(pid, stats);
+
+    pid_t reaped;
+    while((reaped = wait4(pid, status, 0, &stats->usage)) < 0 &&
+          errno == EINTR);
+    stats->exitTime = pipeClock();
+    stats->reaped = reaped == pid;
+}
+
+// Returns the most a pipe can be grown to
+static int pipeMax(void)
+{
+    static int max = 0;
+    if(max == 0)
+    {
+        FILE* fp = fopen(PIPE_MAX_PATH, "r");
+        if(!fp || fscanf(fp, "%d", &max) != 1 || max <= 0)
+        {
+            max = PIPE_MAX_DEFAULT;
+        }
+        if(fp)
+        {
+            fclose(fp);
+        }
+    }
+    return max;
+}
+
+// Remembers to give the pipe from writer to reader size bytes
+static void rememberSize(const CMD* writer, const CMD* reader, int size)
+{
+    adaptEntry* entry = findAdapted(writer, reader);
+    if(!entry)
+    {
+        entry = &adapted[nextAdapted];
+        nextAdapted = (nextAdapted + 1) % ADAPT_ENTRIES;
+        nAdapted += (nAdapted < ADAPT_ENTRIES);
+        snprintf(entry->key, sizeof(entry->key), "%s|%s", stageName(writer),
+                 stageName(reader));
+    }
+    entry->size = size;
+}
+
+void finishPipes(CMD* pipeRoot, const int* sizes, const stageStats* stats,
+                 double start)
+{
+    bool trace = tracingPipes();
+    bool adaptive = adapting();
+
+    int i = 0;
+    for(CMD* cmd = pipeRoot; ISPIPE(cmd->type); cmd = cmd->right, i++)
+    {
+        const CMD* writer = cmd->left;
+        const CMD* reader = ISPIPE(cmd->right->type) ? cmd->right->left :
+                                                       cmd->right;
+        const stageStats* w = &stats[i];
+        const stageStats* r = &stats[i + 1];
+
+        unsigned long long bytes = (w->reaped && w->wchar) ? w->wchar :
+                                   r->reaped ? r->rchar : 0;
+        double end = w->reaped ? w->exitTime :
+                     r->reaped ? r->exitTime : pipeClock();
+        double secs = end - start;
+        long wBlocks = w->reaped ? w->usage.ru_nvcsw : 0;
+        long rBlocks = r->reaped ? r->usage.ru_nvcsw : 0;
+
+        if(trace)
+        {
+            fprintf(stderr, "pipe %d (%s | %s): %d-byte buffer, %llu bytes in "
+                    "%.3f s (%.1f MB/s), blocked %ld/%ld times\n", i + 1,
+                    stageName(writer), stageName(reader), sizes[i], bytes,
+                    secs, (secs > 0) ? bytes / secs / 1e6 : 0.0, wBlocks,
+                    rBlocks);
+        }
+
+        long blocks = wBlocks + rBlocks;
+        if(adaptive && sizes[i] > 0 && blocks >= ADAPT_MIN_BLOCKS &&
+           (unsigned long long)blocks * ADAPT_FILLS >= bytes / sizes[i])
+        {
+            int size = (sizes[i] <= pipeMax() / 2) ? sizes[i] * 2 : pipeMax();
+            if(size > sizes[i])
+            {
+                rememberSize(writer, reader, size);
+            }
+        }
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * File:   pipeStats.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for sizing the pipes between the stages of a pipeline and
+ * measuring how they did. Two variables, set with setenv, control it:
+ *
+ *   pipesize   the capacity to give every pipe, a number with an optional K
+ *              or M suffix; or "auto", which starts pipes at the default and
+ *              doubles the capacity of the pipe between two commands each
+ *              time its stages block on it often
+ *   pipetrace  if set, report each pipe's capacity, the bytes that went
+ *              through it, its throughput, and how often its stages blocked
+ *              to standard error after each pipeline
+ *
+ * Bytes are counted by the kernel's I/O accounting of the stage writing the
+ * pipe (or, if it has none, of the one reading it), which takes in whatever
+ * else the stage reads or writes, and misses what it splices. Blocking is
+ * counted by the stages' voluntary context switches.
+ */
+
+#ifndef PIPESTATS_H
+#define PIPESTATS_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include "parse.h"
+
+// what is known about a stage of a pipeline once it has exited
+typedef struct
+{
+    bool reaped;                  // are the rest known?
+    struct rusage usage;          // its resource usage
+    unsigned long long rchar;     // bytes it read
+    unsigned long long wchar;     //   and wrote
+    double exitTime;              // when it was reaped, in seconds
+} stageStats;
+
+// Returns true if pipelines need their stages measured, because of
+// $pipetrace or $pipesize auto
+bool measuringPipes(void);
+
+// Returns true if $pipetrace is set
+bool tracingPipes(void);
+
+// Returns the capacity to give the pipe from the stage writer to the stage
+// reader, or 0 to leave the default
+int pipeSize(const CMD* writer, const CMD* reader);
+
+// Returns the current time in seconds, for the start of a pipeline
+double pipeClock(void);
+
+// Waits for the stage pid, setting *status to its wait status and filling in
+// stats
+void reapStage(pid_t pid, int* status, stageStats* stats);
+
+// Records how the pipes of the pipeline rooted at pipeRoot, started at start,
+// did: sizes holds the capacity of each of its pipes and stats the stats of
+// its stages. Reports them if $pipetrace is set, and adapts their sizes if
+// $pipesize is auto.
+void finishPipes(CMD* pipeRoot, const int* sizes, const stageStats* stats,
+                 double start);
+
+#endif
@@ -1,6 +1,7 @@
 /* 
  * File:   process.c
  * Author: Alexander Schurman (alexander.schurman@gmail.com)
+ * Modified by: agent (agent@local)
  *
  * Created on November 18, 2012
  * 
@@ -12,15 +13,67 @@
 #include <assert.h>
 #include "process.h"
 #include "builtinCommands.h"
+#include "profile.h"
+#include "zygote.h"
+#include "expand.h"
+#include "spliceStage.h"
+#include "pipeStats.h"
+#include "affinity.h"
+#include "builtinStage.h"
+#include "fdCache.h"
+
+#define MEM_SUBSYSTEM MEM_PROCESS
+#include "memStats.h"
 
 // definitions of file descriptors
 #define STDIN_FD  (0)
 #define STDOUT_FD (1)
 #define STDERR_FD (2)
 
-#define GET_STATUS(x) (WIFEXITED(x) ? WEXITSTATUS(x) : 128 + WTERMSIG(x))
+#define BACKGROUND_INIT_SIZE (16)
+#define BACKGROUND_GROWTH_FACTOR (2)
+
+// the descriptor from the fd cache that the shell found for the file appended
+// to by the command it is forking a child for, which the child's redirect()
+// uses instead of opening the file; -1 if there is none
+static int cachedToFd = -1;
+
+// processes started in the background that haven't been reaped yet; only
+// these are reaped, so that children started by others (e.g., a program
+// using libeggshell) are left to them
+static pid_t* background = NULL;
+static int numBackground = 0, backgroundSize = 0;
+
+// Remembers pid as a process started in the background
+void addBackground(pid_t pid)
+{
+    if(numBackground == backgroundSize)
+    {
+        backgroundSize = backgroundSize ?
+                         backgroundSize * BACKGROUND_GROWTH_FACTOR :
+                         BACKGROUND_INIT_SIZE;
+        background = realloc(background, sizeof(pid_t) * backgroundSize);
+    }
+    background[numBackground++] = pid;
+}
 
-#define EXEC_NAME "eggshell"
+// Reaps the processes started in the background that have finished
+void reapBackground()
+{
+    for(int i = 0; i < numBackground; )
+    {
+        int zombieStatus; // never used after passing to waitpid
+        pid_t pid = waitpid(background[i], &zombieStatus, WNOHANG);
+        if(pid == 0)
+        {
+            i++;
+        }
+        else // reaped, or not ours to reap after all
+        {
+            background[i] = background[--numBackground];
+        }
+    }
+}
 
 // Updates the $? environment variable to contain a base ten string for status
 void updateStatusVar(int status)
@@ -32,6 +85,35 @@ void updateStatusVar(int status)
     setenv("?", statusStr, 1);
 }
 
+int openToFile(CMD* cmd, int flags, bool* cached)
+{
+    int options = O_WRONLY | flags;
+    if(cached)
+    {
+        *cached = false;
+    }
+    
+    if(ISAPPEND(cmd->toType))
+    {
+        bool create = !getenv("noclobber") || ISCLOBBER(cmd->toType);
+        if(cached)
+        {
+            return appendFd(cmd->toFile, create, cached);
+        }
+        options |= O_APPEND | (create ? O_CREAT : 0);
+    }
+    else
+    {
+        options |= O_CREAT | O_TRUNC;
+        if(getenv("noclobber") && !ISCLOBBER(cmd->toType))
+        {
+            options |= O_EXCL;
+        }
+    }
+    
+    return open(cmd->toFile, options, (mode_t)0666);
+}
+
 // Redirects using dup2() based on the given command's redirection
 // fields. Returns 0 for success, -1 for failure. errno is set if -1 is returned
 int redirect(CMD* cmd)
@@ -86,6 +168,7 @@ int redirect(CMD* cmd)
         else
         {
             // parent
+            profileFork();
             close(fd[1]);
             if(fd[0] != STDIN_FD)
             {
@@ -97,25 +180,13 @@ int redirect(CMD* cmd)
     
     if(cmd->toType != NONE)
     {
-        int options = O_WRONLY;
-        if(ISAPPEND(cmd->toType))
+        // the file may already be open in the fd cache
+        bool cached = ISAPPEND(cmd->toType) && cachedToFd >= 0;
+        if(cached)
         {
-            options |= O_APPEND;
-            if(!getenv("noclobber") || ISCLOBBER(cmd->toType))
-            {
-                options |= O_CREAT;
-            }
+            fd = cachedToFd;
         }
-        else
-        {
-            options |= O_CREAT | O_TRUNC;
-            if(getenv("noclobber") && !ISCLOBBER(cmd->toType))
-            {
-                options |= O_EXCL;
-            }
-        }
-        
-        if((fd = open(cmd->toFile, options, (mode_t)0666)) < 0)
+        else if((fd = openToFile(cmd, 0, NULL)) < 0)
         {
             perror(EXEC_NAME);
             return -1;
@@ -126,60 +197,289 @@ int redirect(CMD* cmd)
         {
             dup2(fd, STDERR_FD);
         }
-        close(fd);
+        if(!cached)
+        {
+            close(fd);
+        }
     }
     return 0;
 }
 
-// Executes a <simple> redirection. If background == true, the command is
-// executed in the background. Returns the <simple>'s status, or 0 if background
-// is true and we don't wait for it to die.
-int processSimple(CMD* cmd, bool background)
+// Has the zygote launch the <simple> cmd with its redirections applied over
+// the descriptors in, out, and err, which are left open. Returns the pid of
+// its process; 0 if the zygote isn't running or can't launch cmd (a built-in,
+// a subcommand, a command with a HERE document or process substitutions,
+// whose pipes the zygote doesn't have, or one whose arguments need expanding),
+// in which case the caller should fork; or -1 if a redirection fails, with
+// errno set.
+int zygoteSimple(CMD* cmd, int in, int out, int err)
 {
-    if(IS_BUILTIN(cmd->argv[0]))
+    if(!zygoteRunning() || cmd->type != SIMPLE || cmd->subst || cmd->expand ||
+       IS_BUILTIN(cmd->argv[0]) || cmd->fromType == RED_HERE)
     {
-        int status = execBuiltin(cmd);
-        updateStatusVar(status);
-        return status;
+        return 0;
     }
     
-    int pid;
+    int fds[3] = { in, out, err };
+    int fromFd = -1, toFd = -1;
+    bool cached = false; // is toFd the fd cache's?
+    
+    if(cmd->fromType == RED_IN &&
+       (fds[0] = fromFd = open(cmd->fromFile, O_RDONLY | O_CLOEXEC)) < 0)
+    {
+        perror(EXEC_NAME);
+        return -1;
+    }
+    if(cmd->toType != NONE)
+    {
+        if((fds[1] = toFd = openToFile(cmd, O_CLOEXEC, &cached)) < 0)
+        {
+            int error = errno;
+            perror(EXEC_NAME);
+            if(fromFd >= 0)
+            {
+                close(fromFd);
+            }
+            errno = error;
+            return -1;
+        }
+        if(ISERROR(cmd->toType))
+        {
+            fds[2] = toFd;
+        }
+    }
+    
+    int pid = zygoteSpawn(cmd->argv, fds);
+    if(fromFd >= 0)
+    {
+        close(fromFd);
+    }
+    if(toFd >= 0 && !cached)
+    {
+        close(toFd);
+    }
+    return (pid < 0) ? 0 : pid;
+}
+
+void execSimple(CMD* cmd)
+{
+    if(redirect(cmd) < 0)
+    {
+        exit(errno);
+    }
+    execvp(cmd->argv[0], cmd->argv);
+    perror(EXEC_NAME);
+    exit(EXIT_FAILURE);
+}
+
+int spawnSimple(CMD* cmd, int in, int out, int err)
+{
+    // fork only if the zygote doesn't launch cmd, handing the child the file
+    // it appends to if the fd cache has it
+    int pid = zygoteSimple(cmd, in, out, err);
+    if(pid != 0)
+    {
+        return pid;
+    }
+    
+    cachedToFd = ISAPPEND(cmd->toType) ? cachedAppendFd(cmd->toFile) : -1;
     if((pid = fork()) < 0)
     {
-        // error in forking
+        int error = errno;
         perror(EXEC_NAME);
-        return errno;
+        errno = error;
     }
     else if(pid == 0)
     {
         // child
-        if(redirect(cmd) < 0)
+        if(in != STDIN_FD)
         {
-            exit(errno);
+            dup2(in, STDIN_FD);
         }
-        execvp(cmd->argv[0], cmd->argv);
-        perror(EXEC_NAME);
-        exit(EXIT_FAILURE);
+        if(out != STDOUT_FD)
+        {
+            dup2(out, STDOUT_FD);
+        }
+        if(err != STDERR_FD)
+        {
+            dup2(err, STDERR_FD);
+        }
+        if(IS_BUILTIN(cmd->argv[0]))
+        {
+            exit(execBuiltin(cmd));
+        }
+        execSimple(cmd);
     }
     else
     {
-        // parent        
+        // parent
+        profileFork();
+    }
+    cachedToFd = -1;
+    return pid;
+}
+
+int launchSimple(CMD* cmd, bool background);
+
+// Executes the <simple> cmd, whose arguments contain command substitutions, as
+// launchSimple() does, with the substitutions replaced by their commands'
+// output. A command whose arguments expand to nothing does nothing.
+int launchExpanded(CMD* cmd, bool background)
+{
+    argList* args = expandArgs(cmd->argv);
+    if(!args)
+    {
+        updateStatusVar(EXIT_FAILURE);
+        return EXIT_FAILURE;
+    }
+    
+    int status = 0;
+    if(args->argc > 0)
+    {
+        CMD expanded = *cmd;
+        expanded.argc = args->argc;
+        expanded.argv = args->argv;
+        expanded.expand = false;
+        status = launchSimple(&expanded, background);
+    }
+    freeArgList(args);
+    return status;
+}
+
+// Executes a <simple> as processSimple() does, but without its process
+// substitutions, which the caller has started
+int launchSimple(CMD* cmd, bool background)
+{
+    if(cmd->expand)
+    {
+        return launchExpanded(cmd, background);
+    }
+    
+    if(IS_BUILTIN(cmd->argv[0]))
+    {
+        int status = execBuiltin(cmd);
+        updateStatusVar(status);
+        return status;
+    }
+    
+    int pid = spawnSimple(cmd, STDIN_FD, STDOUT_FD, STDERR_FD);
+    if(pid < 0)
+    {
+        // the redirection or the fork failed
+        int status = errno;
         if(background)
         {
             return 0;
         }
+        updateStatusVar(status);
+        return status;
+    }
+    else if(background)
+    {
+        addBackground(pid);
+        return 0;
+    }
+    else
+    {
+        int status;
+        signal(SIGINT, SIG_IGN);
+        waitpid(pid, &status, 0);
+        signal(SIGINT, SIG_DFL);
+        
+        int exitStatus = GET_STATUS(status);
+        updateStatusVar(exitStatus);
+        return exitStatus;
+    }
+}
+
+// Executes the <simple> cmd, which has process substitutions, as
+// processSimple() does. Each substitution's command is run in a subshell
+// connected to cmd by a pipe, whose end is passed to cmd as /dev/fd/N in place
+// of the substitution's argument. The subshells are waited for along with cmd,
+// or left in the background with it.
+int processSubstituted(CMD* cmd, bool background)
+{
+    int numSubst = 0;
+    for(CMD* s = cmd->subst; s; s = s->right, numSubst++);
+    
+    int pids[numSubst]; // subshells of the substitutions
+    int fds[numSubst];  //   and this process's ends of their pipes
+    char paths[numSubst][sizeof("/dev/fd/") + 11]; // the args naming them
+    char* args[cmd->argc + 1];
+    memcpy(args, cmd->argv, sizeof(char*) * (cmd->argc + 1));
+    
+    int n = 0;
+    for(CMD* s = cmd->subst; s; s = s->right, n++)
+    {
+        int fd[2], pid;
+        if(pipe(fd) < 0 || (pid = fork()) < 0)
+        {
+            perror(EXEC_NAME);
+            break;
+        }
+        
+        // the subshell writes to <( and reads from >(
+        int mine = (s->type == PROC_IN) ? fd[0] : fd[1];
+        int theirs = (s->type == PROC_IN) ? fd[1] : fd[0];
+        if(pid == 0)
+        {
+            // child; only cmd should hold the other pipes open
+            for(int i = 0; i < n; i++)
+            {
+                close(fds[i]);
+            }
+            close(mine);
+            dup2(theirs, (s->type == PROC_IN) ? STDOUT_FD : STDIN_FD);
+            close(theirs);
+            exit(process(s->left));
+        }
+        
+        // parent
+        profileFork();
+        close(theirs);
+        pids[n] = pid;
+        fds[n] = mine;
+        snprintf(paths[n], sizeof(paths[n]), "/dev/fd/%d", mine);
+        args[s->argc] = paths[n];
+    }
+    
+    int status = errno;
+    if(n == numSubst)
+    {
+        CMD substituted = *cmd;
+        substituted.argv = args;
+        status = launchSimple(&substituted, background);
+    }
+    
+    // with this process's ends closed, each subshell sees end of file or a
+    // broken pipe once cmd is done with its pipe
+    for(int i = 0; i < n; i++)
+    {
+        close(fds[i]);
+    }
+    for(int i = 0; i < n; i++)
+    {
+        if(background)
+        {
+            addBackground(pids[i]);
+        }
         else
         {
-            int status;
             signal(SIGINT, SIG_IGN);
-            waitpid(pid, &status, 0);
+            while(waitpid(pids[i], NULL, 0) < 0 && errno == EINTR);
             signal(SIGINT, SIG_DFL);
-            
-            int exitStatus = GET_STATUS(status);
-            updateStatusVar(exitStatus);
-            return exitStatus;
         }
     }
+    return status;
+}
+
+// Executes a <simple> redirection. If background == true, the command is
+// executed in the background. Returns the <simple>'s status, or 0 if background
+// is true and we don't wait for it to die.
+int processSimple(CMD* cmd, bool background)
+{
+    return cmd->subst ? processSubstituted(cmd, background) :
+                        launchSimple(cmd, background);
 }
 
 // Creates a subshell and executes cmd in it. Returns the status of the
@@ -207,8 +507,10 @@ int processSubcommand(CMD* cmd, CMD* subcmdNode, bool background)
     else
     {
         // parent
+        profileFork();
         if(background)
         {
+            addBackground(pid);
             return 0;
         }
         else
@@ -242,6 +544,20 @@ int processStage(CMD* cmd)
     }
 }
 
+// Closes, in a child forked for a stage of a pipeline, the pipes written by the
+// first n stages that run on threads (those with threads[i] non-NULL), which
+// are threadOut[i]
+static void closeThreadOut(builtinStage** threads, const int* threadOut, int n)
+{
+    for(int i = 0; i < n; i++)
+    {
+        if(threads[i])
+        {
+            close(threadOut[i]);
+        }
+    }
+}
+
 // Executes a pipeline and returns the exit status of the pipe. The arg
 // pipeRoot is the PIPE or PIPE_ERR command at the root of the pipeline.
 // This function draws upon code from Professor Stan Eisenstat at Yale
@@ -258,14 +574,70 @@ int execPipe(CMD* pipeRoot)
     } processTable[numStages];
     
     int fd[2];             // holds file descriptors for the pipe
-    int pid, status;       //   the pid and status of a single stage
+    int pid;               //   the pid of a single stage
     int fdIn = STDIN_FD;   //   the read end of the last pipe, or the original
                            //   stdin
     
+    // with $pipetrace or $pipesize auto, how the pipes and stages did
+    bool measure = measuringPipes();
+    int pipeSizes[numStages];
+    stageStats stats[numStages];
+    double start = measure ? pipeClock() : 0;
+    
+    // with $pipeaffinity, the CPUs each stage is pinned to before it execs
+    cpu_set_t placement[numStages];
+    bool placed = placeStages(numStages, placement);
+    if(placed && tracingPipes())
+    {
+        reportPlacement(pipeRoot, placement);
+    }
+    
+    // the built-in stages running on threads, which write to the pipes in
+    // threadOut; the shell holds those open, so its children close them
+    builtinStage* threads[numStages];
+    int threadOut[numStages];
+    
     CMD* cmd = pipeRoot;
     for(int i = 0; ISPIPE(cmd->type); cmd = cmd->right, i++)
     {
-        if(pipe(fd) < 0 || (pid = fork()) < 0)
+        if(pipe(fd) < 0)
+        {
+            perror(EXEC_NAME);
+            return errno;
+        }
+        
+        int size = pipeSize(cmd->left, ISPIPE(cmd->right->type) ?
+                                       cmd->right->left : cmd->right);
+        if(size > 0 && fcntl(fd[1], F_SETPIPE_SZ, size) < 0 && measure)
+        {
+            perror("pipesize");
+        }
+        if(measure)
+        {
+            pipeSizes[i] = fcntl(fd[1], F_GETPIPE_SZ);
+        }
+        
+        // a built-in that only writes runs on a thread of the shell; the rest
+        // fork only if the zygote doesn't launch them, and a cat or tee runs
+        // in the child itself, as does a stage to be placed
+        threads[i] = NULL;
+        if(isBuiltinStage(cmd->left))
+        {
+            fcntl(fd[1], F_SETFD, FD_CLOEXEC);
+            threads[i] = startBuiltinStage(cmd->left, fd[1]);
+            threadOut[i] = fd[1];
+            processTable[i].pid = -1;
+        }
+        else if((pid = (isSpliceStage(cmd->left) || placed) ? 0 :
+                       zygoteSimple(cmd->left, fdIn, fd[1],
+                                    (cmd->type == PIPE_ERR) ? fd[1] :
+                                                              STDERR_FD)) < 0)
+        {
+            // the redirection failed, as it would have in the child
+            processTable[i].pid = -1;
+            processTable[i].status = W_EXITCODE(errno, 0);
+        }
+        else if(pid == 0 && (pid = fork()) < 0)
         {
             perror(EXEC_NAME);
             return errno;
@@ -274,6 +646,7 @@ int execPipe(CMD* pipeRoot)
         {
             // child
             close(fd[0]);
+            closeThreadOut(threads, threadOut, i);
             
             // redirect stdin to the last pipe read (if there was a last pipe)
             if(fdIn != STDIN_FD)
@@ -300,20 +673,32 @@ int execPipe(CMD* pipeRoot)
             
             if(shouldCloseFD1) close(fd[1]);
             
+            if(placed)
+            {
+                sched_setaffinity(0, sizeof(cpu_set_t), &placement[i]);
+            }
+            if(isSpliceStage(cmd->left))
+            {
+                runSpliceStage(cmd->left);
+            }
             exit(processStage(cmd->left));
         }
         else
         {
             // parent
+            profileFork();
             processTable[i].pid = pid;
-            
-            // close the read end of the last pipe if it's not the orig stdin
-            if(i > 0)
-            {
-                close(fdIn);
-            }
-            
-            fdIn = fd[0]; // remember the read end of the new pipe
+        }
+        
+        // close the read end of the last pipe if it's not the orig stdin
+        if(i > 0)
+        {
+            close(fdIn);
+        }
+        
+        fdIn = fd[0]; // remember the read end of the new pipe
+        if(!threads[i])
+        {
             close(fd[1]);
         }
     }
@@ -321,14 +706,25 @@ int execPipe(CMD* pipeRoot)
     // the pipeline
     
     // if the last stage is a built-in command, it should affect the parent
-    // shell, so execute it here instead of forking off a process
-    if(cmd->type == SIMPLE && IS_BUILTIN(cmd->argv[0]))
+    // shell, so execute it here instead of forking off a process, unless it
+    // reads the pipeline
+    if(cmd->type == SIMPLE && IS_BUILTIN(cmd->argv[0]) &&
+       !IS_FILTER_BUILTIN(cmd->argv[0]))
     {
         processTable[numStages - 1].pid = -1; // unused pid
-        processTable[numStages - 1].status = processSimple(cmd, false);
+        processTable[numStages - 1].status =
+            W_EXITCODE(processSimple(cmd, false), 0);
         close(fdIn);
     }
-    else if((pid = fork()) < 0)
+    else if((pid = (isSpliceStage(cmd) || placed) ? 0 :
+                   zygoteSimple(cmd, fdIn, STDOUT_FD, STDERR_FD)) < 0)
+    {
+        // the redirection failed, as it would have in the child
+        processTable[numStages - 1].pid = -1;
+        processTable[numStages - 1].status = W_EXITCODE(errno, 0);
+        close(fdIn);
+    }
+    else if(pid == 0 && (pid = fork()) < 0)
     {
         perror(EXEC_NAME);
         return errno;
@@ -336,38 +732,67 @@ int execPipe(CMD* pipeRoot)
     else if(pid == 0)
     {
         // child
+        closeThreadOut(threads, threadOut, numStages - 1);
         if(fdIn != STDIN_FD)
         {
             dup2(fdIn, STDIN_FD);
             close(fdIn);
         }
+        if(placed)
+        {
+            sched_setaffinity(0, sizeof(cpu_set_t), &placement[numStages - 1]);
+        }
+        if(isSpliceStage(cmd))
+        {
+            runSpliceStage(cmd);
+        }
         exit(processStage(cmd));
     }
     else
     {
         // parent
+        profileFork();
         processTable[numStages - 1].pid = pid;
         close(fdIn);
     }
     
-    // wait for children to die
+    // finish the stages on threads first, closing their pipes so that their
+    // readers see the end
+    for(int i = 0; i < numStages - 1; i++)
+    {
+        if(threads[i])
+        {
+            processTable[i].status = finishBuiltinStage(threads[i]);
+            close(threadOut[i]);
+        }
+    }
+    
+    // wait for children to die; stages without a process (pid -1) already
+    // have their statuses
     signal(SIGINT, SIG_IGN);
-    for(int i = 0; i < numStages; )
+    for(int i = 0; i < numStages; i++)
     {
-        pid = wait(&status);
-        int j;
-        for(j = 0; j < numStages && processTable[j].pid != pid; j++);
-        
-        // only add to the processTable if the child's pid is in the table;
-        // that is, ignore zombies
-        if(j < numStages)
+        if(processTable[i].pid > 0 && measure)
         {
-            processTable[j].status = status;
-            i++;
+            reapStage(processTable[i].pid, &processTable[i].status, &stats[i]);
+        }
+        else if(processTable[i].pid > 0)
+        {
+            while(waitpid(processTable[i].pid, &processTable[i].status, 0) < 0
+                  && errno == EINTR);
+        }
+        else
+        {
+            stats[i].reaped = false;
         }
     }
     signal(SIGINT, SIG_DFL);
     
+    if(measure)
+    {
+        finishPipes(pipeRoot, pipeSizes, stats, start);
+    }
+    
     for(int i = 0; i < numStages; i++)
     {
         if(GET_STATUS(processTable[i].status) != 0)
@@ -431,8 +856,7 @@ int process(CMD* cmd)
 {    
     if(!cmd) return 0;
     
-    int zombieStatus; // never used after passing to waitpid
-    while(waitpid(-1, &zombieStatus, WNOHANG) > 0); // reap zombie processes
+    reapBackground(); // reap zombie processes
     
     int exitStatus;
     
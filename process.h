@@ -17,5 +17,29 @@
 #include <setjmp.h>
 #include "parse.h"
 
+// The exit status of a child whose wait() status is X, as the shell reports
+// it: 128 plus the signal number if it was killed
+#define GET_STATUS(x) (WIFEXITED(x) ? WEXITSTATUS(x) : 128 + WTERMSIG(x))
+
+// The name the shell's errors are reported under
+#define EXEC_NAME "eggshell"
+
 // Execute command list CMDLIST and return status of last command executed
 int process (CMD *cmdList);
+
+// Open CMD->toFile as CMD->toType calls for, with FLAGS added to the open()
+// flags, and return the descriptor, or -1 with errno set. If CACHED isn't
+// NULL, a file appended to may come from the fd cache (see fdCache.h), in
+// which case *CACHED is set and the descriptor mustn't be closed
+int openToFile (CMD *cmd, int flags, bool *cached);
+
+// Start the <simple> command CMD, without its process substitutions, with
+// standard input IN, output OUT, and error ERR (which should be close-on-exec)
+// under its redirections, by the zygote if it is running or else by fork(),
+// and return its pid without waiting for it; or return -1 with errno set if a
+// redirection or the fork fails
+int spawnSimple (CMD *cmd, int in, int out, int err);
+
+// Apply the redirections of the <simple> command CMD to this process and exec
+// it; exits if either fails
+void execSimple (CMD *cmd) __attribute__((noreturn));
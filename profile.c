@@ -0,0 +1,185 @@
+/*
+ * File:   profile.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the script line profiler described in profile.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "profile.h"
+
+#define PROFILE_INIT_SIZE (64)
+#define PROFILE_GROWTH_FACTOR (2)
+
+// number of characters of each line's text kept for the report
+#define PROFILE_TEXT_LEN (40)
+
+typedef struct {
+    unsigned long lineNum; // source line number, or 0 if never executed
+    unsigned long hits;    // number of times the line was executed
+    unsigned long forks;   // number of fork()s made for the line
+    double wall;           // wall time in seconds
+    double childCPU;       // user + system time of reaped children in seconds
+    char* text;            // the first PROFILE_TEXT_LEN chars of the line
+} lineProfile;
+
+static bool profiling = false;
+static pid_t profilePid;  // pid of the shell, so children don't report
+static FILE* reportFile;
+
+static lineProfile* lines = NULL; // profiles indexed by line number
+static unsigned long linesSize = 0;
+
+static lineProfile* current = NULL; // line of the command being executed
+static double startWall, startChildCPU;
+
+// Returns the current monotonic time in seconds
+static double wallTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Returns the user + system time used by all reaped children in seconds
+static double childCPUTime(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_CHILDREN, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+// Orders profiles by decreasing wall time
+static int compareProfiles(const void* a, const void* b)
+{
+    const lineProfile* x = a;
+    const lineProfile* y = b;
+    return (x->wall < y->wall) - (x->wall > y->wall);
+}
+
+// Prints the report; registered with atexit() by startProfile()
+static void printProfile(void)
+{
+    if(getpid() != profilePid)
+    {
+        return; // a forked child is exiting
+    }
+
+    // compact the executed lines to the front of the table and sort them
+    unsigned long n = 0;
+    double totalWall = 0, totalCPU = 0;
+    unsigned long totalForks = 0;
+    for(unsigned long i = 0; i < linesSize; i++)
+    {
+        if(lines[i].hits)
+        {
+            totalWall += lines[i].wall;
+            totalCPU += lines[i].childCPU;
+            totalForks += lines[i].forks;
+            lines[n++] = lines[i];
+        }
+    }
+    qsort(lines, n, sizeof(lineProfile), compareProfiles);
+
+    fprintf(reportFile, "%8s %8s %12s %12s %8s  %s\n",
+            "line", "hits", "wall(ms)", "cpu(ms)", "forks", "command");
+    for(unsigned long i = 0; i < n; i++)
+    {
+        fprintf(reportFile, "%8lu %8lu %12.3f %12.3f %8lu  %s\n",
+                lines[i].lineNum, lines[i].hits, lines[i].wall * 1e3,
+                lines[i].childCPU * 1e3, lines[i].forks,
+                lines[i].text ? lines[i].text : "");
+        free(lines[i].text);
+    }
+    fprintf(reportFile, "%8s %8s %12.3f %12.3f %8lu\n",
+            "total", "", totalWall * 1e3, totalCPU * 1e3, totalForks);
+    fflush(reportFile);
+
+    free(lines);
+    lines = NULL;
+    linesSize = 0;
+}
+
+void startProfile(FILE* fp)
+{
+    if(profiling)
+    {
+        return;
+    }
+
+    profiling = true;
+    profilePid = getpid();
+    reportFile = fp;
+    atexit(printProfile);
+}
+
+void profileBegin(unsigned long lineNum, const char* line)
+{
+    if(!profiling)
+    {
+        return;
+    }
+
+    // grow the table to hold lineNum if necessary
+    if(lineNum >= linesSize)
+    {
+        unsigned long newSize = linesSize ? linesSize : PROFILE_INIT_SIZE;
+        while(lineNum >= newSize)
+        {
+            newSize *= PROFILE_GROWTH_FACTOR;
+        }
+        lines = realloc(lines, sizeof(lineProfile) * newSize);
+        memset(lines + linesSize, 0,
+               sizeof(lineProfile) * (newSize - linesSize));
+        linesSize = newSize;
+    }
+
+    current = &lines[lineNum];
+    if(!current->hits)
+    {
+        current->lineNum = lineNum;
+        // line is NULL when the command's text isn't known (e.g. it was lexed
+        // straight from the input stream); the report shows an empty command
+        line = line ? line : "";
+        current->text = strndup(line, strcspn(line, "\n"));
+        if(current->text && strlen(current->text) > PROFILE_TEXT_LEN)
+        {
+            strcpy(current->text + PROFILE_TEXT_LEN - 3, "...");
+        }
+    }
+    current->hits++;
+
+    startChildCPU = childCPUTime();
+    startWall = wallTime();
+}
+
+void profileEnd(void)
+{
+    if(!profiling || !current)
+    {
+        return;
+    }
+
+    current->wall += wallTime() - startWall;
+    current->childCPU += childCPUTime() - startChildCPU;
+    current = NULL;
+}
+
+void profileFork(void)
+{
+    if(profiling && current && getpid() == profilePid)
+    {
+        current->forks++;
+    }
+}
@@ -0,0 +1,34 @@
+/*
+ * File:   profile.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for the script line profiler. While profiling, each command is
+ * charged to the source line it begins on: the number of times the line was
+ * executed, the wall time spent executing it, the CPU time of the children it
+ * reaped, and the number of processes the shell forked for it. A report sorted
+ * by wall time is printed when the shell exits.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+
+// Starts profiling; the report is printed to fp when the shell exits
+void startProfile(FILE* fp);
+
+// Marks the start of a command beginning on source line lineNum, whose text is
+// line, or NULL if the text isn't known. Does nothing if not profiling.
+void profileBegin(unsigned long lineNum, const char* line);
+
+// Marks the end of the command started by the last profileBegin(). Does
+// nothing if not profiling.
+void profileEnd(void);
+
+// Counts a fork() made by the shell for the current command. Does nothing if
+// not profiling.
+void profileFork(void);
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * File:   rawInput.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the raw input reader described in rawInput.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include "rawInput.h"
+#include "getwc.h"
+
+// most characters decoded by one read()
+#define RAW_BUFFER_SIZE (64 * 1024)
+
+static FILE* rawFp = NULL; // stream being read raw, or NULL if none
+static int rawFd;
+static bool ended = false; // reached end of file or invalid input?
+
+static char decoded[RAW_BUFFER_SIZE];
+static size_t decodedLen = 0;
+static size_t decodedPos = 0; // next character to return
+
+// input read but not yet decoded in INPUT_WHITESPACE mode; only the start of
+// an encoding split between reads is left here between calls to refill()
+static char encoded[RAW_BUFFER_SIZE * WS_BITS];
+static size_t encodedLen = 0;
+
+// Reads a block of plain text input, which needs no decoding, straight into
+// decoded. Returns false at end of file.
+static bool readNormal(void)
+{
+    ssize_t n;
+    while((n = read(rawFd, decoded, sizeof(decoded))) < 0 && errno == EINTR);
+    if(n <= 0)
+    {
+        return false;
+    }
+    decodedLen = n;
+    return true;
+}
+
+// Reads and decodes a block of white-space input. Returns false at end of
+// file or invalid input, after decoding any characters before the invalid
+// one.
+static bool readWhitespace(void)
+{
+    ssize_t n;
+    while((n = read(rawFd, encoded + encodedLen,
+                    sizeof(encoded) - encodedLen)) < 0 && errno == EINTR);
+    if(n <= 0)
+    {
+        return false; // a partial encoding at end of file is dropped
+    }
+    encodedLen += n;
+
+    size_t nChars = encodedLen / WS_BITS;
+    decodedLen = decodeWhitespace(encoded, nChars, decoded);
+
+    // carry over the start of a split encoding
+    encodedLen -= nChars * WS_BITS;
+    memmove(encoded, encoded + nChars * WS_BITS, encodedLen);
+
+    return decodedLen == nChars; // invalid input ends it, as in inputGetwc()
+}
+
+// reads the next block in the input mode; chosen once by startRawInput()
+static bool (*readBlock)(void);
+
+// Reads and decodes the next block of input. Returns false if there is none.
+static bool refill(void)
+{
+    decodedPos = 0;
+    decodedLen = 0;
+
+    while(decodedLen == 0 && !ended)
+    {
+        ended = !readBlock();
+    }
+
+    return decodedLen > 0;
+}
+
+void startRawInput(FILE* fp)
+{
+    rawFp = fp;
+    rawFd = fileno(fp);
+    readBlock = (inputCharWidth == 1) ? readNormal : readWhitespace;
+}
+
+int inputGetc(FILE* fp)
+{
+    if(fp != rawFp)
+    {
+        return inputGetwc(fp);
+    }
+    if(decodedPos == decodedLen && !refill())
+    {
+        return EOF;
+    }
+    return (unsigned char)decoded[decodedPos++];
+}
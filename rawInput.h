@@ -0,0 +1,30 @@
+/*
+ * File:   rawInput.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for the raw input reader. Once started for a stream, its file
+ * descriptor is read with read() into a buffer of the reader's own, bypassing
+ * stdio, and each read is decoded as a block in the input mode. An
+ * encoding split between two reads is carried over to the next, so line and
+ * character boundaries needn't line up with reads. Interactive input is read
+ * with one read() per batch of lines the terminal delivers.
+ */
+
+#ifndef RAWINPUT_H
+#define RAWINPUT_H
+
+#include <stdio.h>
+
+// Makes inputGetc() read fp's file descriptor directly, decoding it in the
+// current input mode, which must not change afterwards. fp must not have been
+// read through stdio.
+void startRawInput(FILE* fp);
+
+// Returns the next decoded character of fp, or EOF at end of file or invalid
+// input. Reads through the raw input buffer if fp is the stream it was started
+// for, otherwise with inputGetwc().
+int inputGetc(FILE* fp);
+
+#endif
@@ -0,0 +1,191 @@
+/*
+ * File:   readAhead.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the read-ahead front end described in readAhead.h. The
+ * queue is a ring with a single producer (the read-ahead thread) and a single
+ * consumer (the main thread); each end owns its index, and a pair of
+ * semaphores counting the filled and empty entries both blocks each end when
+ * it has to wait and orders the entries' contents between the threads.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "readAhead.h"
+#include "getLine.h"
+#include "parse.h"
+
+#define MEM_SUBSYSTEM MEM_PARSE
+#include "memStats.h"
+
+typedef struct {
+    char* line;            // the line read, or NULL at end of file
+    unsigned long lineNum; // source line it begins on
+    token* list;           // its tokens
+    CMD* cmd;              //   and parsed command
+    char* errors;          // errors found parsing it, or NULL if none
+} queuedLine;
+
+static queuedLine* queue = NULL;
+static int queueSize;
+static int head = 0; // next entry to remove; used only by the main thread
+static int tail = 0; // next entry to fill; used only by the read-ahead thread
+static sem_t filled; // number of filled entries
+static sem_t empty;  // number of empty entries
+
+// lines queued so far; used only by the read-ahead thread
+static unsigned long nQueued = 0;
+
+// lines finished executing, and the number the read-ahead thread is waiting
+// for (0 if none); accessed atomically by both threads
+static unsigned long nDone = 0;
+static unsigned long waitingFor = 0;
+static sem_t drained; // posted when nDone reaches waitingFor
+
+// errors found parsing the line being read; used only by the read-ahead thread
+static char* errors = NULL;
+
+// Waits for the semaphore s, retrying if interrupted
+static void semWait(sem_t* s)
+{
+    while(sem_wait(s) < 0);
+}
+
+// Saves an error found parsing the line being read, so it can be printed when
+// the line is reached; the read-ahead thread's parse error handler
+static void saveError(const char* msg)
+{
+    size_t len = errors ? strlen(errors) : 0;
+    errors = realloc(errors, len + strlen(msg) + 1);
+    strcpy(errors + len, msg);
+}
+
+// Returns true if parsing list depends on the state left by earlier commands
+static bool dependsOnState(token* list)
+{
+    for(token* t = list; t; t = t->next)
+    {
+        if(t->type == RED_HERE) // expands variables an earlier setenv may set
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Waits until every line queued so far has finished executing
+static void waitForDrain(void)
+{
+    if(nQueued == 0)
+    {
+        return;
+    }
+
+    // the main thread posts drained if it finishes the last line after
+    // seeing waitingFor, so at least one of us sees the other's store
+    __atomic_store_n(&waitingFor, nQueued, __ATOMIC_SEQ_CST);
+    while(__atomic_load_n(&nDone, __ATOMIC_SEQ_CST) < nQueued)
+    {
+        semWait(&drained); // may be a stale post; the loop checks again
+    }
+    __atomic_store_n(&waitingFor, 0, __ATOMIC_SEQ_CST);
+}
+
+// Reads and parses lines into the queue until end of file; the start routine
+// of the read-ahead thread
+static void* readAheadThread(void* arg)
+{
+    queuedLine q;
+
+    setParseErrorHandler(saveError);
+    do
+    {
+        q.lineNum = getLineCount() + 1;
+        q.line = getJoinedLine(stdin);
+        q.list = q.line ? tokenize(q.line) : NULL;
+        if(dependsOnState(q.list))
+        {
+            waitForDrain();
+        }
+        q.cmd = q.list ? parse(q.list) : NULL;
+        q.errors = errors;
+        errors = NULL;
+
+        semWait(&empty);
+        queue[tail] = q;
+        tail = (tail + 1) % queueSize;
+        nQueued++;
+        sem_post(&filled);
+    } while(q.line);
+
+    return NULL;
+}
+
+int startReadAhead(int depth)
+{
+    pthread_t thread;
+    sigset_t all, old;
+
+    queueSize = depth;
+    queue = malloc(sizeof(queuedLine) * queueSize);
+    sem_init(&filled, 0, 0);
+    sem_init(&empty, 0, queueSize);
+    sem_init(&drained, 0, 0);
+
+    // signals are left to the main thread, which runs the commands
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int err = pthread_create(&thread, NULL, readAheadThread, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    if(err)
+    {
+        sem_destroy(&filled);
+        sem_destroy(&empty);
+        sem_destroy(&drained);
+        free(queue);
+        queue = NULL;
+        return -1;
+    }
+
+    pthread_detach(thread);
+    return 0;
+}
+
+bool nextReadAhead(char** line, unsigned long* lineNum, token** list,
+                   CMD** cmd)
+{
+    semWait(&filled);
+    queuedLine* q = &queue[head];
+    head = (head + 1) % queueSize;
+
+    *line = q->line;
+    *lineNum = q->lineNum;
+    *list = q->list;
+    *cmd = q->cmd;
+    if(q->errors)
+    {
+        fputs(q->errors, stderr);
+        free(q->errors);
+    }
+    sem_post(&empty);
+
+    return *line != NULL;
+}
+
+void readAheadDone(void)
+{
+    unsigned long done = __atomic_add_fetch(&nDone, 1, __ATOMIC_SEQ_CST);
+    if(done == __atomic_load_n(&waitingFor, __ATOMIC_SEQ_CST))
+    {
+        sem_post(&drained);
+    }
+}
@@ -0,0 +1,39 @@
+/*
+ * File:   readAhead.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for the read-ahead front end. While the shell executes a command,
+ * a second thread reads, tokenizes, and parses the command lines that follow
+ * it into a bounded queue, so the next command is ready to run as soon as the
+ * last one finishes. A command line with a here document is not parsed until
+ * every earlier line has finished executing: the here document's $NAME
+ * variables are expanded as it is parsed, and an earlier setenv or unsetenv
+ * may change them. Errors found parsing a line are held until the line is
+ * reached.
+ */
+
+#ifndef READAHEAD_H
+#define READAHEAD_H
+
+#include <stdbool.h>
+#include "parse.h"
+
+// Starts the read-ahead thread, which reads lines with getJoinedLine(stdin)
+// and queues up to depth parsed lines. Returns 0 if successful, -1 if the
+// thread can't be started.
+int startReadAhead(int depth);
+
+// Removes the next line from the queue, waiting for it to be parsed if
+// necessary. Sets *line to the malloc'd line, *lineNum to the number of the
+// source line it begins on, *list to its tokens, and *cmd to its parsed
+// command; *list and *cmd may be NULL, as for an empty line or a syntax error.
+// Returns false at end of file.
+bool nextReadAhead(char** line, unsigned long* lineNum, token** list,
+                   CMD** cmd);
+
+// Marks the line last returned by nextReadAhead() as finished executing
+void readAheadDone(void);
+
+#endif
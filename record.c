@@ -0,0 +1,164 @@
+/*
+ * File:   record.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of session recording as described in record.h. Records are
+ * gathered in a buffer written with write() rather than stdio so that forked
+ * children, which exit() with a copy of the buffer, never write it.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "record.h"
+#include "getLine.h"
+#include "fullIO.h"
+
+#define RECORD_BUFFER_SIZE (64 * 1024)
+
+// maximum bytes taken by one varint of an unsigned long long
+#define VARINT_MAX (10)
+
+static bool recording = false;
+static pid_t recordPid; // pid of the shell, so children don't write the log
+static int recordFd;
+
+static unsigned char buffer[RECORD_BUFFER_SIZE];
+static size_t bufferLen = 0;
+
+static unsigned long long startTime; // when recording started
+static unsigned long long beginTime; // when the current command started
+
+// Returns the current monotonic time in microseconds
+static unsigned long long microTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+// Writes the buffered records to the log
+static void flushRecords(void)
+{
+    if(!writeAll(recordFd, buffer, bufferLen))
+    {
+        perror("record");
+    }
+    bufferLen = 0;
+}
+
+// Flushes the log when the shell exits; registered with atexit()
+static void finishRecording(void)
+{
+    if(getpid() == recordPid)
+    {
+        flushRecords();
+        close(recordFd);
+    }
+}
+
+// Appends len bytes at data to the buffer, flushing it as necessary
+static void appendBytes(const void* data, size_t len)
+{
+    const unsigned char* p = data;
+    while(len > 0)
+    {
+        if(bufferLen == RECORD_BUFFER_SIZE)
+        {
+            flushRecords();
+        }
+
+        size_t n = RECORD_BUFFER_SIZE - bufferLen;
+        n = (n < len) ? n : len;
+        memcpy(buffer + bufferLen, p, n);
+        bufferLen += n;
+        p += n;
+        len -= n;
+    }
+}
+
+// Appends x to the buffer as an unsigned LEB128 varint
+static void appendVarint(unsigned long long x)
+{
+    unsigned char bytes[VARINT_MAX];
+    int n = 0;
+    do
+    {
+        bytes[n] = x & 0x7F;
+        x >>= 7;
+        if(x)
+        {
+            bytes[n] |= 0x80;
+        }
+        n++;
+    } while(x);
+
+    appendBytes(bytes, n);
+}
+
+// Records a line returned by getLine(); installed as its line observer
+static void recordLine(const char* line)
+{
+    size_t len = strlen(line);
+    unsigned char type = RECORD_LINE;
+
+    appendBytes(&type, 1);
+    appendVarint(microTime() - startTime);
+    appendVarint(len);
+    appendBytes(line, len);
+}
+
+int startRecording(const char* path)
+{
+    if(recording)
+    {
+        return 0;
+    }
+
+    if((recordFd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                        (mode_t)0666)) < 0)
+    {
+        return -1;
+    }
+
+    recording = true;
+    recordPid = getpid();
+    startTime = microTime();
+    appendBytes(RECORD_MAGIC, strlen(RECORD_MAGIC));
+
+    setLineObserver(recordLine);
+    atexit(finishRecording);
+    return 0;
+}
+
+void recordBegin(void)
+{
+    if(recording)
+    {
+        beginTime = microTime();
+    }
+}
+
+void recordEnd(int status)
+{
+    if(!recording)
+    {
+        return;
+    }
+
+    unsigned char type = RECORD_STATUS;
+    appendBytes(&type, 1);
+    appendVarint((unsigned int)status);
+    appendVarint(microTime() - beginTime);
+
+    // flush after each command so the log is usable if the shell is killed
+    flushRecords();
+}
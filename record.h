@@ -0,0 +1,42 @@
+/*
+ * File:   record.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for recording a session to a log that can be replayed against
+ * another build of Eggshell (see replay.h).
+ *
+ * A session log begins with the 8 bytes of RECORD_MAGIC and is followed by
+ * records, each a type byte and unsigned LEB128 varints:
+ *
+ *   RECORD_LINE   time, length, text  a line returned by getLine(); time is in
+ *                                     microseconds since recording started
+ *                                     and text is length bytes of decoded
+ *                                     ASCII, including the newline (if any)
+ *   RECORD_STATUS status, duration    a command finished with exit status
+ *                                     status after running for duration
+ *                                     microseconds
+ *
+ * The lines of a command (including its here documents) precede its status.
+ */
+
+#ifndef RECORD_H
+#define RECORD_H
+
+#define RECORD_MAGIC  "EGGREC1\n"
+#define RECORD_LINE   ('L')
+#define RECORD_STATUS ('S')
+
+// Starts recording the session to the file path, truncating it. Returns 0 if
+// successful, -1 with errno set otherwise.
+int startRecording(const char* path);
+
+// Marks the start of a command. Does nothing if not recording.
+void recordBegin(void);
+
+// Records that the command started by the last recordBegin() finished with
+// exit status status. Does nothing if not recording.
+void recordEnd(int status);
+
+#endif
@@ -0,0 +1,310 @@
+/*
+ * File:   replay.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of session replay as described in replay.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "replay.h"
+#include "record.h"
+#include "getLine.h"
+
+// the lines handed to getLine() replace its input, so everything allocated
+// here is charged to MEM_GETLINE
+#define MEM_SUBSYSTEM MEM_GETLINE
+#include "memStats.h"
+
+#define RECORDS_INIT_SIZE (256)
+#define RECORDS_GROWTH_FACTOR (2)
+#define LATENCY_INIT_SIZE (256)
+#define LATENCY_GROWTH_FACTOR (2)
+
+typedef struct {
+    int type;                    // RECORD_LINE or RECORD_STATUS
+    unsigned long long time;     // RECORD_LINE: microseconds since start
+    const char* text;            // RECORD_LINE: text of the line
+    size_t len;                  //   and its length
+    int status;                  // RECORD_STATUS: recorded exit status
+    unsigned long long duration; //   and microseconds the command ran
+} replayRecord;
+
+static bool replaying = false;
+static bool paced;
+static pid_t replayPid; // pid of the shell, so children don't report
+
+static char* logData = NULL; // contents of the session log
+static replayRecord* records = NULL;
+static size_t nRecords = 0;
+static size_t next = 0;   // index of the next record to replay
+
+static unsigned long linesRead = 0;   // number of lines replayed
+static unsigned long commandLine = 0; // line the current command began on
+static bool inCommand = false;        // read a line since the last status?
+
+static unsigned long long startTime; // when the replay started
+static unsigned long long beginTime; // when the current command started
+
+static double* latencies = NULL; // latency of each command in seconds
+static size_t nLatencies = 0, latenciesSize = 0;
+static unsigned long long recordedTime = 0; // sum of recorded durations
+static unsigned long divergences = 0;
+
+// Returns the current monotonic time in microseconds
+static unsigned long long microTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+// Reads an unsigned LEB128 varint from *p, which may not pass end, into *x.
+// Advances *p past the varint. Returns true if successful, false if the varint
+// is truncated or too long.
+static bool readVarint(const char** p, const char* end,
+                       unsigned long long* x)
+{
+    *x = 0;
+    for(int shift = 0; *p < end && shift < 64; shift += 7)
+    {
+        unsigned char byte = *(*p)++;
+        *x |= (unsigned long long)(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Splits the log of length len into records. Returns true if successful.
+static bool parseLog(size_t len)
+{
+    const char* end = logData + len;
+    const char* p = logData + strlen(RECORD_MAGIC);
+    size_t size = 0;
+
+    while(p < end)
+    {
+        if(nRecords == size)
+        {
+            size = size ? size * RECORDS_GROWTH_FACTOR : RECORDS_INIT_SIZE;
+            records = realloc(records, sizeof(replayRecord) * size);
+        }
+        replayRecord* rec = &records[nRecords];
+        unsigned long long a, b;
+
+        rec->type = *p++;
+        if(!readVarint(&p, end, &a) || !readVarint(&p, end, &b))
+        {
+            return false;
+        }
+
+        if(rec->type == RECORD_LINE)
+        {
+            if(b > (unsigned long long)(end - p))
+            {
+                return false;
+            }
+            rec->time = a;
+            rec->text = p;
+            rec->len = b;
+            p += b;
+        }
+        else if(rec->type == RECORD_STATUS)
+        {
+            rec->status = (int)a;
+            rec->duration = b;
+        }
+        else
+        {
+            return false;
+        }
+        nRecords++;
+    }
+
+    return true;
+}
+
+// Orders doubles increasingly
+static int compareDoubles(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Returns the q quantile of the sorted latencies in milliseconds
+static double percentile(double q)
+{
+    return latencies[(size_t)(q * (nLatencies - 1))] * 1e3;
+}
+
+// Prints the replay report; registered with atexit() by startReplay()
+static void printReport(void)
+{
+    if(getpid() != replayPid)
+    {
+        return; // a forked child is exiting
+    }
+
+    double elapsed = (microTime() - startTime) / 1e6;
+    fprintf(stderr, "replay: %zu commands in %.3f s (%.1f commands/s), "
+            "recorded %.3f s\n", nLatencies, elapsed,
+            elapsed > 0 ? nLatencies / elapsed : 0.0, recordedTime / 1e6);
+
+    if(nLatencies > 0)
+    {
+        qsort(latencies, nLatencies, sizeof(double), compareDoubles);
+        fprintf(stderr, "replay: latency ms p50 %.3f  p90 %.3f  p99 %.3f  "
+                "max %.3f\n", percentile(0.5), percentile(0.9),
+                percentile(0.99), latencies[nLatencies - 1] * 1e3);
+    }
+    fprintf(stderr, "replay: %lu divergences\n", divergences);
+
+    free(latencies);
+    free(records);
+    free(logData);
+}
+
+// Returns a malloc'd copy of the next logged line, or NULL at the end of the
+// log; installed as getLine()'s line source
+static char* replayLine(void)
+{
+    // skip the statuses of commands that didn't run in this replay
+    for( ; next < nRecords && records[next].type == RECORD_STATUS; next++)
+    {
+        fprintf(stderr, "replay: line %lu: recorded command did not run\n",
+                commandLine);
+        divergences++;
+        inCommand = false;
+    }
+
+    if(next == nRecords)
+    {
+        return NULL;
+    }
+
+    replayRecord* rec = &records[next++];
+    linesRead++;
+    if(!inCommand)
+    {
+        commandLine = linesRead;
+        inCommand = true;
+    }
+
+    if(paced)
+    {
+        unsigned long long now = microTime() - startTime;
+        if(now < rec->time)
+        {
+            struct timespec delay = {
+                (rec->time - now) / 1000000,
+                (rec->time - now) % 1000000 * 1000
+            };
+            while(nanosleep(&delay, &delay) < 0 && errno == EINTR);
+        }
+    }
+
+    char* line = malloc(rec->len + 1);
+    memcpy(line, rec->text, rec->len);
+    line[rec->len] = '\0';
+    return line;
+}
+
+int startReplay(const char* path, bool pace)
+{
+    int fd;
+    struct stat st;
+
+    if((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &st) < 0)
+    {
+        perror("replay");
+        return -1;
+    }
+
+    logData = malloc(st.st_size + 1);
+    size_t len = 0;
+    for(ssize_t n; len < (size_t)st.st_size; len += n)
+    {
+        if((n = read(fd, logData + len, st.st_size - len)) <= 0)
+        {
+            break;
+        }
+    }
+    close(fd);
+
+    if(len < strlen(RECORD_MAGIC) ||
+       memcmp(logData, RECORD_MAGIC, strlen(RECORD_MAGIC)) != 0 ||
+       !parseLog(len))
+    {
+        fprintf(stderr, "replay: %s is not a valid session log\n", path);
+        free(records);
+        free(logData);
+        records = NULL;
+        logData = NULL;
+        return -1;
+    }
+
+    replaying = true;
+    paced = pace;
+    replayPid = getpid();
+    startTime = microTime();
+
+    setLineSource(replayLine);
+    atexit(printReport);
+    return 0;
+}
+
+void replayBegin(void)
+{
+    if(replaying)
+    {
+        beginTime = microTime();
+    }
+}
+
+void replayEnd(int status)
+{
+    if(!replaying)
+    {
+        return;
+    }
+
+    if(nLatencies == latenciesSize)
+    {
+        latenciesSize = latenciesSize ? latenciesSize * LATENCY_GROWTH_FACTOR
+                                      : LATENCY_INIT_SIZE;
+        latencies = realloc(latencies, sizeof(double) * latenciesSize);
+    }
+    latencies[nLatencies++] = (microTime() - beginTime) / 1e6;
+
+    if(next < nRecords && records[next].type == RECORD_STATUS)
+    {
+        if(records[next].status != status)
+        {
+            fprintf(stderr, "replay: line %lu: exit status %d, recorded %d\n",
+                    commandLine, status, records[next].status);
+            divergences++;
+        }
+        recordedTime += records[next].duration;
+        next++;
+    }
+    else
+    {
+        fprintf(stderr, "replay: line %lu: command was not run when "
+                "recorded\n", commandLine);
+        divergences++;
+    }
+    inCommand = false;
+}
@@ -0,0 +1,32 @@
+/*
+ * File:   replay.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for replaying a session log written by record.h. The logged lines
+ * are fed to the shell in place of its standard input, either as fast as
+ * possible or with their original pacing, and the exit status of each command
+ * is compared to the recorded one. When the shell exits, a report of the
+ * throughput, latency percentiles, and exit status divergences is printed to
+ * stderr.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+
+// Loads the session log at path and makes getLine() read from it. If paced,
+// each line is supplied no earlier than it was read when recorded. Returns 0
+// if successful, -1 otherwise (with a message printed to stderr).
+int startReplay(const char* path, bool paced);
+
+// Marks the start of a command. Does nothing if not replaying.
+void replayBegin(void);
+
+// Marks the end of the command started by the last replayBegin(), which
+// finished with exit status status. Does nothing if not replaying.
+void replayEnd(int status);
+
+#endif
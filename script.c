@@ -0,0 +1,188 @@
+/*
+ * File:   script.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of script loading as described in script.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "script.h"
+#include "getLine.h"
+#include "getwc.h"
+#include "scriptCache.h"
+
+// the script replaces getLine()'s input, so the decoded script and the lines
+// handed out are charged to MEM_GETLINE
+#define MEM_SUBSYSTEM MEM_GETLINE
+#include "memStats.h"
+
+// fewest characters worth handing to a decoding thread
+#define MIN_CHUNK_CHARS (1 << 20)
+
+// most decoding threads to start
+#define MAX_THREADS (64)
+
+typedef struct {
+    const char* in;  // encoded input of this chunk
+    char* out;       //   and where to decode it
+    size_t nChars;   // number of characters in the chunk
+    size_t nDecoded; // number decoded before any invalid input
+} chunk;
+
+static const char* script = NULL; // the decoded script
+static char* decoded = NULL; // the script if decoded here, or NULL
+static void* cached = NULL;  // the cache entry it was mapped from, or NULL
+static size_t cachedLen = 0; //   and the length of that mapping
+static size_t scriptLen = 0;
+static size_t scriptPos = 0; // offset of the next line in script
+
+// Decodes a chunk; the start routine of each decoding thread
+static void* decodeChunk(void* arg)
+{
+    chunk* c = arg;
+    c->nDecoded = decodeInput(c->in, c->nChars, c->out);
+    return NULL;
+}
+
+// Decodes the nChars characters encoded at in to out, splitting the work
+// among threads when there is enough of it. Returns the number of characters
+// before the first invalid encoding, as inputGetwc() would read.
+static size_t decodeParallel(const char* in, size_t nChars, char* out)
+{
+    long nThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if(nThreads > MAX_THREADS)
+    {
+        nThreads = MAX_THREADS;
+    }
+    if(nThreads > (long)(nChars / MIN_CHUNK_CHARS))
+    {
+        nThreads = nChars / MIN_CHUNK_CHARS;
+    }
+    if(nThreads <= 1)
+    {
+        return decodeInput(in, nChars, out);
+    }
+
+    chunk chunks[nThreads];
+    pthread_t threads[nThreads];
+    bool started[nThreads];
+    size_t perThread = (nChars + nThreads - 1) / nThreads;
+
+    for(long i = 0; i < nThreads; i++)
+    {
+        size_t first = i * perThread;
+        chunks[i].in = in + first * inputCharWidth;
+        chunks[i].out = out + first;
+        chunks[i].nChars = (perThread < nChars - first) ? perThread
+                                                        : nChars - first;
+
+        // the first chunk is decoded by this thread once the others have
+        // started, as is any chunk whose thread can't be created
+        started[i] = i > 0 && pthread_create(&threads[i], NULL, decodeChunk,
+                                             &chunks[i]) == 0;
+        if(i > 0 && !started[i])
+        {
+            decodeChunk(&chunks[i]);
+        }
+    }
+    decodeChunk(&chunks[0]);
+
+    for(long i = 1; i < nThreads; i++)
+    {
+        if(started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    // the script ends at the first invalid character of any chunk
+    size_t len = 0;
+    for(long i = 0; i < nThreads; i++)
+    {
+        len += chunks[i].nDecoded;
+        if(chunks[i].nDecoded < chunks[i].nChars)
+        {
+            break;
+        }
+    }
+    return len;
+}
+
+// Returns a malloc'd copy of the next line of the script, or NULL at its end;
+// installed as getLine()'s line source
+static char* scriptLine(void)
+{
+    if(scriptPos == scriptLen)
+    {
+        free(decoded);
+        if(cached)
+        {
+            munmap(cached, cachedLen);
+        }
+        script = decoded = cached = NULL;
+        return NULL;
+    }
+
+    const char* start = script + scriptPos;
+    const char* newline = memchr(start, '\n', scriptLen - scriptPos);
+    size_t len = newline ? (size_t)(newline - start) + 1
+                         : scriptLen - scriptPos;
+
+    char* line = malloc(len + 1);
+    memcpy(line, start, len);
+    line[len] = '\0';
+    scriptPos += len;
+    return line;
+}
+
+int loadScript(int fd)
+{
+    struct stat st;
+    off_t offset;
+
+    if(fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) ||
+       (offset = lseek(fd, 0, SEEK_CUR)) < 0 || offset >= st.st_size)
+    {
+        return -1;
+    }
+
+    char* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map == MAP_FAILED)
+    {
+        return -1;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    // plain text needs no decoding, so only encoded scripts are cached
+    size_t inLen = st.st_size - offset;
+    bool useCache = inputCharWidth > 1;
+    if(!useCache || !(cached = findCachedScript(&st, offset, map + offset,
+                                                inLen, &script, &scriptLen,
+                                                &cachedLen)))
+    {
+        decoded = malloc(inLen / inputCharWidth + 1);
+        scriptLen = decodeParallel(map + offset, inLen / inputCharWidth,
+                                   decoded);
+        script = decoded;
+        if(useCache)
+        {
+            cacheScript(&st, offset, map + offset, inLen, script, scriptLen);
+        }
+    }
+    munmap(map, st.st_size);
+
+    scriptPos = 0;
+    lseek(fd, 0, SEEK_END);
+    setLineSource(scriptLine);
+    return 0;
+}
@@ -0,0 +1,26 @@
+/*
+ * File:   script.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for loading a whole script into memory. Since every character is
+ * encoded by exactly inputCharWidth input chars, a large script is split into
+ * chunks at character boundaries that are decoded in parallel by a pool of
+ * threads.
+ * getLine() then returns lines from the decoded script instead of reading its
+ * file pointer. Decoded scripts are cached (see scriptCache.h), so a script
+ * that is run again unchanged needn't be decoded again.
+ */
+
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+// Loads the rest of the script open on fd, which must be a regular file, and
+// makes getLine() read lines from it. fd's offset is moved to the end of the
+// file, as if the script had been read through it. Returns 0 if successful, -1
+// if fd is not a regular file or cannot be mapped, in which case nothing is
+// changed.
+int loadScript(int fd);
+
+#endif
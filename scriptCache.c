@@ -0,0 +1,191 @@
+/*
+ * File:   scriptCache.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the decoded-script cache described in scriptCache.h. An
+ * entry is a header followed by the decoded script. Entries are written to a
+ * temporary file that is then renamed into place, so a shell mapping an entry
+ * never sees one half written.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "scriptCache.h"
+#include "cacheDir.h"
+#include "getwc.h"
+#include "fullIO.h"
+
+#define MEM_SUBSYSTEM MEM_GETLINE
+#include "memStats.h"
+
+// name of the cache directory under $HOME/.eggshell
+#define SCRIPT_CACHE_NAME "scripts"
+
+// defaults for EGGSHELL_CACHE_SIZE (bytes) and EGGSHELL_CACHE_AGE (days)
+#define CACHE_DEFAULT_SIZE (64ULL << 20)
+#define CACHE_DEFAULT_AGE (30)
+
+#define CACHE_MAGIC "EGGDEC1"
+
+typedef struct {
+    char magic[8];                 // CACHE_MAGIC
+    unsigned long long dev, ino;   // identity of the script
+    unsigned long long offset;     //   and where it starts
+    unsigned long long size;       // size of the script file
+    long long mtimeSec, mtimeNsec; //   and its modification time
+    unsigned long long width;      // input chars per decoded char
+    unsigned long long hash;       // cacheHash() of the encoded script
+    unsigned long long len;        // length of the decoded script
+} cacheHeader;
+
+// Fills in the header of the entry for the script described by st from
+// offset, except for its hash and length
+static void makeHeader(cacheHeader* h, const struct stat* st, off_t offset)
+{
+    memset(h, 0, sizeof(cacheHeader));
+    memcpy(h->magic, CACHE_MAGIC, sizeof(h->magic));
+    h->dev = st->st_dev;
+    h->ino = st->st_ino;
+    h->offset = offset;
+    h->size = st->st_size;
+    h->mtimeSec = st->st_mtim.tv_sec;
+    h->mtimeNsec = st->st_mtim.tv_nsec;
+    h->width = inputCharWidth;
+}
+
+// Returns the malloc'd path of the entry for the script identified by h, or
+// NULL if the cache is disabled or its directory can't be created
+static char* entryPath(const cacheHeader* h)
+{
+    if(envNumber("EGGSHELL_CACHE_SIZE", CACHE_DEFAULT_SIZE) == 0)
+    {
+        return NULL;
+    }
+
+    char* dir = cacheDir(SCRIPT_CACHE_NAME);
+    if(!dir)
+    {
+        return NULL;
+    }
+
+    unsigned long long id[3] = { h->dev, h->ino, h->offset };
+    size_t len = strlen(dir) + 18;
+    char* path = malloc(len);
+    snprintf(path, len, "%s/%016llx", dir,
+             cacheHash(id, sizeof(id), 0));
+    free(dir);
+    return path;
+}
+
+void* findCachedScript(const struct stat* st, off_t offset, const char* in,
+                       size_t inLen, const char** text, size_t* len,
+                       size_t* mapLen)
+{
+    cacheHeader want;
+    makeHeader(&want, st, offset);
+
+    char* path = entryPath(&want);
+    if(!path)
+    {
+        return NULL;
+    }
+    int fd = open(path, O_RDONLY);
+    free(path);
+
+    struct stat est;
+    if(fd < 0 || fstat(fd, &est) < 0 ||
+       (size_t)est.st_size < sizeof(cacheHeader))
+    {
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+        return NULL;
+    }
+
+    void* map = mmap(NULL, est.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map == MAP_FAILED)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    // everything but the hash and length must match before the hash is worth
+    // computing
+    cacheHeader* have = map;
+    want.hash = have->hash;
+    want.len = have->len;
+    if(memcmp(have, &want, sizeof(cacheHeader)) != 0 ||
+       sizeof(cacheHeader) + have->len != (size_t)est.st_size ||
+       cacheHash(in, inLen, 0) != have->hash)
+    {
+        munmap(map, est.st_size);
+        close(fd);
+        return NULL;
+    }
+
+    futimens(fd, NULL); // mark the entry used for eviction
+    close(fd);
+
+    *text = (const char*)(have + 1);
+    *len = have->len;
+    *mapLen = est.st_size;
+    return map;
+}
+
+void cacheScript(const struct stat* st, off_t offset, const char* in,
+                 size_t inLen, const char* text, size_t len)
+{
+    unsigned long long maxSize = envNumber("EGGSHELL_CACHE_SIZE",
+                                           CACHE_DEFAULT_SIZE);
+    if(sizeof(cacheHeader) + len > maxSize)
+    {
+        return;
+    }
+
+    cacheHeader h;
+    makeHeader(&h, st, offset);
+    h.hash = cacheHash(in, inLen, 0);
+    h.len = len;
+
+    char* path = entryPath(&h);
+    if(!path)
+    {
+        return;
+    }
+
+    size_t tmpLen = strlen(path) + 32;
+    char* tmp = malloc(tmpLen);
+    snprintf(tmp, tmpLen, "%s.%ld.tmp", path, (long)getpid());
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if(fd >= 0)
+    {
+        bool written = writeAll(fd, &h, sizeof(h)) && writeAll(fd, text, len);
+        if(close(fd) < 0 || !written || rename(tmp, path) < 0)
+        {
+            unlink(tmp);
+        }
+    }
+
+    char* dir = cacheDir(SCRIPT_CACHE_NAME);
+    if(dir)
+    {
+        evictCache(dir, maxSize,
+                   envNumber("EGGSHELL_CACHE_AGE", CACHE_DEFAULT_AGE) * 86400);
+        free(dir);
+    }
+
+    free(tmp);
+    free(path);
+}
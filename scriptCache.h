@@ -0,0 +1,41 @@
+/*
+ * File:   scriptCache.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for the decoded-script cache. The decoded text of each script
+ * loaded whole is kept in $HOME/.eggshell/scripts, in an entry named for the
+ * script's device, inode, and starting offset, so a script run again
+ * unchanged is mapped from its entry rather than decoded. An entry is only
+ * reused if the script's size and modification time match the ones recorded
+ * in it, and so does a hash of its encoded contents, which is much cheaper to
+ * compute than decoding them.
+ *
+ * The cache is limited by two environment variables: EGGSHELL_CACHE_SIZE, the
+ * most bytes it may hold (with an optional K, M, or G suffix; 0 disables it),
+ * and EGGSHELL_CACHE_AGE, the days an unused entry is kept.
+ */
+
+#ifndef SCRIPTCACHE_H
+#define SCRIPTCACHE_H
+
+#include <stddef.h>
+#include <sys/stat.h>
+
+// Looks up the decoded script for the file described by st whose encoded
+// contents from offset are the inLen chars at in. If it is cached, returns a
+// mapping of the entry, setting *text to the decoded script within it, *len to
+// the script's length, and *mapLen to the length of the mapping. Returns NULL
+// if it is not cached.
+void* findCachedScript(const struct stat* st, off_t offset, const char* in,
+                       size_t inLen, const char** text, size_t* len,
+                       size_t* mapLen);
+
+// Caches the len chars at text as the decoded script for the file described by
+// st whose encoded contents from offset are the inLen chars at in, evicting
+// entries as needed to stay within the limits
+void cacheScript(const struct stat* st, off_t offset, const char* in,
+                 size_t inLen, const char* text, size_t len);
+
+#endif
@@ -0,0 +1,273 @@
+/*
+ * File:   server.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of server mode as described in server.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include "server.h"
+#include "fullIO.h"
+
+#define MEM_SUBSYSTEM MEM_PROCESS
+#include "memStats.h"
+
+// connections waiting to be accepted
+#define LISTEN_BACKLOG (128)
+
+static int clientFd = -1; // connection of the request being served
+
+// Receives the header of a request on fd and the descriptors attached to it,
+// storing up to REQUEST_MAX_FDS of them in fds. Returns the number received,
+// or -1 on error.
+static int receiveHeader(int fd, requestHeader* hdr, int* fds)
+{
+    char control[CMSG_SPACE(sizeof(int) * REQUEST_MAX_FDS)];
+    struct iovec iov = { hdr, sizeof(requestHeader) };
+    struct msghdr msg;
+    ssize_t n;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    while((n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR);
+    if(n <= 0)
+    {
+        return -1;
+    }
+
+    int nFds = 0;
+    for(struct cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c))
+    {
+        if(c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS)
+        {
+            int n = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for(int i = 0; i < n; i++)
+            {
+                int received;
+                memcpy(&received, CMSG_DATA(c) + i * sizeof(int), sizeof(int));
+                if(nFds < REQUEST_MAX_FDS)
+                {
+                    fds[nFds++] = received;
+                }
+                else
+                {
+                    close(received);
+                }
+            }
+        }
+    }
+
+    // the descriptors come with the first byte; read the rest of the header
+    if(!readAll(fd, (char*)hdr + n, sizeof(requestHeader) - n))
+    {
+        return -1;
+    }
+    return nFds;
+}
+
+// Closes the nFds descriptors in fds
+static void closeAll(int* fds, int nFds)
+{
+    for(int i = 0; i < nFds; i++)
+    {
+        close(fds[i]);
+    }
+}
+
+// Takes on the request on the connection fd: its descriptors, working
+// directory, and environment. Returns true if successful, or false if the
+// request is malformed or its directory can't be entered.
+static bool takeRequest(int fd, char** command, int* scriptFd)
+{
+    requestHeader hdr;
+    int fds[REQUEST_MAX_FDS];
+    int nFds = receiveHeader(fd, &hdr, fds);
+
+    if(nFds < 3 || memcmp(hdr.magic, REQUEST_MAGIC, sizeof(hdr.magic)) != 0 ||
+       hdr.cwdLen > REQUEST_MAX_CWD || hdr.envLen > REQUEST_MAX_ENV ||
+       hdr.commandLen > REQUEST_MAX_COMMAND)
+    {
+        fprintf(stderr, "eggshell: malformed request\n");
+        closeAll(fds, nFds);
+        return false;
+    }
+
+    size_t bodyLen = (size_t)hdr.cwdLen + hdr.envLen + hdr.commandLen;
+    char* body = malloc(bodyLen + 1);
+    if(!body)
+    {
+        perror("eggshell");
+        closeAll(fds, nFds);
+        return false;
+    }
+    else if(!readAll(fd, body, bodyLen))
+    {
+        fprintf(stderr, "eggshell: truncated request\n");
+        free(body);
+        closeAll(fds, nFds);
+        return false;
+    }
+    body[bodyLen] = '\0';
+
+    for(int i = 0; i < 3; i++)
+    {
+        dup2(fds[i], i);
+        close(fds[i]);
+    }
+    *scriptFd = (nFds > 3) ? fds[3] : -1;
+
+    // a request run in the server's directory instead of the client's could
+    // act on the wrong files, so it fails
+    char cwd[REQUEST_MAX_CWD + 1];
+    memcpy(cwd, body, hdr.cwdLen);
+    cwd[hdr.cwdLen] = '\0';
+    if(chdir(cwd) < 0)
+    {
+        perror(cwd);
+        free(body);
+        if(*scriptFd >= 0)
+        {
+            close(*scriptFd);
+        }
+        return false;
+    }
+
+    // the environment strings stay in body for the life of the worker
+    clearenv();
+    for(char *var = body + hdr.cwdLen, *end = var + hdr.envLen; var < end;
+        var += strlen(var) + 1)
+    {
+        putenv(var);
+    }
+
+    *command = hdr.commandLen ? strdup(body + hdr.cwdLen + hdr.envLen) : NULL;
+    return true;
+}
+
+// Forks a worker that waits for a request on listenFd. Returns its pid in the
+// server, or 0 in the worker.
+static pid_t startWorker(int listenFd)
+{
+    pid_t pid = fork();
+    if(pid != 0)
+    {
+        return pid;
+    }
+
+    prctl(PR_SET_PDEATHSIG, SIGTERM); // don't outlive the server
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGINT, SIG_DFL);
+    return 0;
+}
+
+int serve(const char* path, int nWorkers, char** command, int* scriptFd)
+{
+    struct sockaddr_un addr;
+    struct stat st;
+
+    if(strlen(path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "eggshell: socket path too long\n");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    // replace the socket of a server that's gone
+    if(stat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+    {
+        unlink(path);
+    }
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(listenFd < 0 ||
+       bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+       listen(listenFd, LISTEN_BACKLOG) < 0)
+    {
+        perror(path);
+        return -1;
+    }
+
+    pid_t workers[nWorkers];
+    for(int i = 0; i < nWorkers; i++)
+    {
+        if((workers[i] = startWorker(listenFd)) == 0)
+        {
+            goto worker;
+        }
+    }
+
+    // replace each worker as it finishes
+    for( ; ; )
+    {
+        pid_t pid = wait(NULL);
+        if(pid < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            perror("eggshell");
+            exit(EXIT_FAILURE);
+        }
+
+        for(int i = 0; i < nWorkers; i++)
+        {
+            if(workers[i] == pid && (workers[i] = startWorker(listenFd)) == 0)
+            {
+                goto worker;
+            }
+        }
+    }
+
+worker:
+    while((clientFd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC)) < 0)
+    {
+        if(errno != EINTR)
+        {
+            perror("eggshell");
+            exit(EXIT_FAILURE);
+        }
+    }
+    close(listenFd);
+
+    if(!takeRequest(clientFd, command, scriptFd))
+    {
+        finishRequest(EXIT_FAILURE);
+        exit(EXIT_FAILURE);
+    }
+    return 0;
+}
+
+void finishRequest(int status)
+{
+    if(clientFd < 0)
+    {
+        return;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    writeAll(clientFd, &status, sizeof(status));
+    close(clientFd);
+    clientFd = -1;
+}
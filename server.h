@@ -0,0 +1,57 @@
+/*
+ * File:   server.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for server mode, in which the shell listens on a Unix domain
+ * socket and runs the scripts and command lines that eggclient sends it, so
+ * clients skip the cost of starting a shell. A pool of workers is forked in
+ * advance; each accepts one request, takes on the client's working directory,
+ * environment, and standard input, output, and error, runs the request as
+ * the shell would, sends the client its exit status, and exits, whereupon a
+ * fresh worker takes its place.
+ *
+ * A request is a requestHeader, sent with the client's descriptors attached
+ * as SCM_RIGHTS, followed by its working directory, its environment as a
+ * sequence of null-terminated strings, and its command line. A fourth
+ * descriptor, if attached, is the script to run. The reply is the exit status
+ * as an int.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#define REQUEST_MAGIC "EGGREQ1"
+
+// most descriptors attached to a request: stdin, stdout, stderr, and script
+#define REQUEST_MAX_FDS (4)
+
+// most bytes of each part of a request's body (the first is Linux's PATH_MAX);
+// a request with a longer one is malformed
+#define REQUEST_MAX_CWD     (4096)
+#define REQUEST_MAX_ENV     (16 << 20)
+#define REQUEST_MAX_COMMAND (16 << 20)
+
+typedef struct {
+    char magic[8];           // REQUEST_MAGIC
+    unsigned int cwdLen;     // length of the working directory
+    unsigned int envLen;     // length of the environment strings
+    unsigned int commandLen; // length of the command line; 0 if none
+} requestHeader;
+
+// Serves requests on the Unix domain socket at path with nWorkers workers.
+// Returns only in a worker once it has taken on a request's directory,
+// environment, and descriptors: with *command set to the malloc'd command line
+// to run if there is one, or else *scriptFd set to the script to run if there
+// is one (or -1 for commands from standard input). The worker then runs it as
+// usual and calls finishRequest(). A request whose working directory can't
+// be entered fails with EXIT_FAILURE rather than running elsewhere, as does a
+// malformed one, such as one with a part longer than its REQUEST_MAX_ limit.
+// Returns -1 if the socket can't be set up.
+int serve(const char* path, int nWorkers, char** command, int* scriptFd);
+
+// Sends status to the client whose request is being served, if any
+void finishRequest(int status);
+
+#endif
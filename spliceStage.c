@@ -0,0 +1,316 @@
+/*
+ * File:   spliceStage.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the in-shell cat and tee described in spliceStage.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include "spliceStage.h"
+#include "process.h"
+#include "expand.h"
+#include "fullIO.h"
+
+#define MEM_SUBSYSTEM MEM_PROCESS
+#include "memStats.h"
+
+// the most moved by one call; a pipe holds 64K by default
+#define CHUNK_SIZE (64 * 1024)
+
+// how copyFd() moves the bytes, in the order it falls back through them
+enum {
+    VIA_SPLICE,     // one side is a pipe
+    VIA_COPY_RANGE, // file to file, possibly without touching the data
+    VIA_SENDFILE,   // file to anything
+    VIA_READ        // read() and write()
+};
+
+// Returns true if errno says that a way of moving bytes doesn't apply to the
+// descriptors it was tried on
+#define UNSUPPORTED(e) ((e) == EINVAL || (e) == ENOSYS || (e) == EXDEV || \
+                        (e) == EOPNOTSUPP || (e) == EBADF)
+
+static char buf[CHUNK_SIZE]; // for read() and write()
+
+// Returns true if fd is a pipe
+static bool isPipe(int fd)
+{
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+// Returns true if fd is a regular file
+static bool isFile(int fd)
+{
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+// Copies everything from in to out, within the kernel if it can. Returns 0,
+// or -1 with errno set.
+static int copyFd(int in, int out)
+{
+    int via = (isPipe(in) || isPipe(out)) ? VIA_SPLICE :
+              !isFile(in)                 ? VIA_READ :
+              isFile(out)                 ? VIA_COPY_RANGE : VIA_SENDFILE;
+
+    for( ; ; )
+    {
+        ssize_t n;
+        switch(via)
+        {
+            case VIA_SPLICE:
+                n = splice(in, NULL, out, NULL, CHUNK_SIZE,
+                           SPLICE_F_MOVE | SPLICE_F_MORE);
+                break;
+            case VIA_COPY_RANGE:
+                n = copy_file_range(in, NULL, out, NULL, CHUNK_SIZE, 0);
+                break;
+            case VIA_SENDFILE:
+                n = sendfile(out, in, NULL, CHUNK_SIZE);
+                break;
+            default:
+                if((n = read(in, buf, sizeof(buf))) > 0 &&
+                   !writeAll(out, buf, n))
+                {
+                    n = -1;
+                }
+                break;
+        }
+
+        if(n == 0)
+        {
+            return 0;
+        }
+        else if(n < 0 && errno != EINTR)
+        {
+            if(via == VIA_READ || !UNSUPPORTED(errno))
+            {
+                return -1;
+            }
+            // the file positions have kept up, so carry on another way
+            via = (via == VIA_COPY_RANGE && isFile(in)) ? VIA_SENDFILE :
+                                                          VIA_READ;
+        }
+    }
+}
+
+// Moves exactly len bytes from the pipe in to out. Returns 0, or -1 with errno
+// set.
+static int moveAll(int in, int out, size_t len)
+{
+    bool spliced = true;
+    while(len > 0)
+    {
+        ssize_t n;
+        if(spliced)
+        {
+            n = splice(in, NULL, out, NULL, len, SPLICE_F_MOVE);
+        }
+        else if((n = read(in, buf, (len < sizeof(buf)) ? len : sizeof(buf)))
+                > 0 && !writeAll(out, buf, n))
+        {
+            n = -1;
+        }
+
+        if(n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if(n < 0 && spliced && UNSUPPORTED(errno))
+        {
+            spliced = false;
+            continue;
+        }
+        else if(n <= 0)
+        {
+            return -1;
+        }
+        len -= n;
+    }
+    return 0;
+}
+
+// Copies standard input to standard output and file with read() and write().
+// Returns 0, or -1 with errno set.
+static int teeByCopy(int file)
+{
+    ssize_t n;
+    while((n = read(STDIN_FILENO, buf, sizeof(buf))) != 0)
+    {
+        if(n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if(n < 0 || !writeAll(STDOUT_FILENO, buf, n) ||
+                !writeAll(file, buf, n))
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Copies standard input, a pipe, to standard output and file. tee() copies
+// the input to a pipe without consuming it, and splice() then moves the same
+// bytes to file; standard output gets them directly if it's a pipe, and
+// through a spare pipe otherwise. Returns 0, or -1 with errno set.
+static int teeFd(int file)
+{
+    int spare[2] = { -1, -1 };
+    if(!isPipe(STDIN_FILENO) ||
+       (!isPipe(STDOUT_FILENO) && pipe(spare) < 0))
+    {
+        return teeByCopy(file);
+    }
+    int copyTo = (spare[1] >= 0) ? spare[1] : STDOUT_FILENO;
+
+    int status = 0;
+    for( ; ; )
+    {
+        ssize_t n = tee(STDIN_FILENO, copyTo, CHUNK_SIZE, 0);
+        if(n == 0)
+        {
+            break;
+        }
+        else if(n < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            status = -1;
+            break;
+        }
+
+        if(moveAll(STDIN_FILENO, file, n) < 0 ||
+           (spare[0] >= 0 && moveAll(spare[0], STDOUT_FILENO, n) < 0))
+        {
+            status = -1;
+            break;
+        }
+    }
+
+    if(spare[0] >= 0)
+    {
+        close(spare[0]);
+        close(spare[1]);
+    }
+    return status;
+}
+
+// Runs cat with the files args, or standard input if there are none or for
+// "-". Returns its exit status.
+static int cat(char** args)
+{
+    int status = EXIT_SUCCESS;
+    char* stdinArgs[] = { "-", NULL };
+    for(char** arg = *args ? args : stdinArgs; *arg; arg++)
+    {
+        bool isStdin = strcmp(*arg, "-") == 0;
+        int fd = isStdin ? STDIN_FILENO : open(*arg, O_RDONLY | O_CLOEXEC);
+        if(fd < 0 || copyFd(fd, STDOUT_FILENO) < 0)
+        {
+            fprintf(stderr, "cat: %s: %s\n", *arg, strerror(errno));
+            status = EXIT_FAILURE;
+        }
+        if(fd >= 0 && !isStdin)
+        {
+            close(fd);
+        }
+    }
+    return status;
+}
+
+// Runs tee with the file path, appending to it if append is true. Returns its
+// exit status.
+static int teeFile(const char* path, bool append)
+{
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+    int fd = open(path, flags, 0666);
+    if(fd < 0)
+    {
+        // like tee, still copy to standard output
+        fprintf(stderr, "tee: %s: %s\n", path, strerror(errno));
+        copyFd(STDIN_FILENO, STDOUT_FILENO);
+        return EXIT_FAILURE;
+    }
+
+    int status = teeFd(fd);
+    if(status < 0)
+    {
+        fprintf(stderr, "tee: %s\n", strerror(errno));
+    }
+    close(fd);
+    return (status < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// Returns true if arg is an option rather than an operand
+static bool isOption(const char* arg)
+{
+    return arg[0] == '-' && arg[1] != '\0';
+}
+
+bool isSpliceStage(const CMD* cmd)
+{
+    return cmd->type == SIMPLE && !cmd->subst && cmd->fromType == NONE &&
+           cmd->toType == NONE &&
+           (strcmp(cmd->argv[0], "cat") == 0 ||
+            strcmp(cmd->argv[0], "tee") == 0);
+}
+
+void runSpliceStage(CMD* cmd)
+{
+    signal(SIGINT, SIG_DFL);
+    signal(SIGPIPE, SIG_DFL);
+
+    char** argv = cmd->argv;
+    if(cmd->expand)
+    {
+        argList* args = expandArgs(cmd->argv);
+        if(!args)
+        {
+            exit(EXIT_FAILURE);
+        }
+        argv = args->argv; // freed at exit
+    }
+
+    if(strcmp(argv[0], "cat") == 0)
+    {
+        bool options = false;
+        for(char** arg = argv + 1; *arg; arg++)
+        {
+            options = options || isOption(*arg);
+        }
+        if(!options)
+        {
+            exit(cat(argv + 1));
+        }
+    }
+    else
+    {
+        bool append = argv[1] && strcmp(argv[1], "-a") == 0;
+        char** files = argv + 1 + append;
+        if(files[0] && !files[1] && !isOption(files[0]))
+        {
+            exit(teeFile(files[0], append));
+        }
+    }
+
+    // options, or more than one file for tee, are left to the real program
+    execvp(argv[0], argv);
+    perror(EXEC_NAME);
+    exit(EXIT_FAILURE);
+}
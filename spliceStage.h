@@ -0,0 +1,28 @@
+/*
+ * File:   spliceStage.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for running the cat and tee stages of a pipeline in the shell's
+ * own child instead of exec'ing the programs. The bytes are moved within the
+ * kernel, with splice() between a pipe and anything else, tee() to copy a
+ * pipe without consuming it, and sendfile() or copy_file_range() between
+ * files, falling back to read() and write() where none of them apply. A stage
+ * with options other than tee's -a is left to the real program.
+ */
+
+#ifndef SPLICESTAGE_H
+#define SPLICESTAGE_H
+
+#include <stdbool.h>
+#include "parse.h"
+
+// Returns true if the stage cmd is a cat or tee that runSpliceStage() can run
+bool isSpliceStage(const CMD* cmd);
+
+// Runs the stage cmd, for which isSpliceStage() is true, in this process (the
+// stage's child, with its pipes in place), and exits with its status
+void runSpliceStage(CMD* cmd) __attribute__((noreturn));
+
+#endif
@@ -13,6 +13,9 @@
 #include <string.h>
 #include "stack.h"
 
+#define MEM_SUBSYSTEM MEM_BUILTIN
+#include "memStats.h"
+
 #define INIT_STACK_SIZE (10)
 #define STACK_GROWTH_FACTOR (2)
 
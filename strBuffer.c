@@ -11,6 +11,9 @@
 #include <stdlib.h>
 #include "strBuffer.h"
 
+#define MEM_SUBSYSTEM MEM_HEREDOC
+#include "memStats.h"
+
 #define STRBUFFER_INIT_SIZE (10)
 #define STRBUFFER_GROWTH_FACTOR (2)
 
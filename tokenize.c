@@ -2,6 +2,7 @@
  * File:   tokenize.c
  * Original Author: Stan Eisenstat
  * Modified by: Alexander Schurman (alexander.schurman@gmail.com)
+ * Modified by: agent (agent@local)
  *
  * Modified on 20 January 2013 (Sunday)
  * 
@@ -15,6 +16,10 @@
 #include <string.h>
 #include "getLine.h"
 #include "parse.h"
+#include "rawInput.h"
+
+#define MEM_SUBSYSTEM MEM_TOKENIZE
+#include "memStats.h"
 
 // Table of special tokens and their lengths and types, ordered so that any
 // token that is a prefix of another token appears later in the table
@@ -22,8 +27,10 @@
 static struct entry {
     char *text; int length, type;
     } STok[] = {
+    ENTRY ("<(",   PROC_IN),
     ENTRY ("<<",   RED_HERE),
     ENTRY ("<",    RED_IN),
+    ENTRY (">(",   PROC_OUT),
     ENTRY (">>&!", RED_ERR_APP_C),
     ENTRY (">>&",  RED_ERR_APP),
     ENTRY (">>!",  RED_OUT_APP_C),
@@ -90,11 +97,25 @@ token* tokenize (char* line)
         }
                              
         tail->type = SIMPLE;    // SIMPLE token
-        tail->text = strdup(p); // Allocate enough space
+        tail->text = malloc(2 * strlen(p) + 1); // Allocate enough space, even
+                                                //   if every char is marked
         inQuote = 0;
         for(q = tail->text;  *p;  p++) 
         {
-            if(*p == inQuote)                // Matching quote?
+            if(*p == '`' && inQuote != '\'')  // command substitution?
+            {
+                char *end = strchr(p + 1, '`');
+                if(!end)
+                {
+                    break;                   //     Reported below
+                }
+                *q++ = inQuote ? SUBST_QUOTED : SUBST_WORDS;
+                memcpy(q, p + 1, end - p - 1); //   Copy command verbatim
+                q += end - p - 1;
+                *q++ = inQuote ? SUBST_QUOTED : SUBST_WORDS;
+                p = end;
+            }
+            else if(*p == inQuote)           // Matching quote?
             {
                 inQuote = 0;                 //     Suppress close quote
             }
@@ -120,6 +141,11 @@ token* tokenize (char* line)
             else if(!strchr(METACHAR,*p) &&  // non-whitespace non-metachar?
                     !isspace(*p))
             {
+                if(strchr(GLOB_CHARS, *p) && //    Mark unquoted glob char
+                   !(*p == '?' && q > tail->text && q[-1] == '$')) // but $?
+                {
+                    *q++ = GLOB_MARK;
+                }
                 *q++ = *p;                   //     Copy character
             }
             else
@@ -130,9 +156,15 @@ token* tokenize (char* line)
         *q = '\0';
         tail->text = realloc(tail->text, q - tail->text + 1);
 
-        if(inQuote)
+        if(*p == '`')
+        {
+            parseError("Unmatched `\n");
+            freeList(head.next);
+            return NULL;
+        }
+        else if(inQuote)
         {
-            fprintf(stderr, "Unterminated string\n");
+            parseError("Unterminated string\n");
             freeList(head.next);
             return NULL;
         }
@@ -140,3 +172,192 @@ token* tokenize (char* line)
     
     return head.next; // Return token list
 }
+
+
+// Initial allocation for the text of a SIMPLE token read by tokenizeStream()
+#define STREAM_TEXT_SIZE (16)
+
+// Append C to the growable token text *TEXT of length *LEN and allocated size
+// *SIZE
+static void appendText (char **text, int *len, int *size, int c)
+{
+    if(*len == *size - 1)
+    {
+        *size *= 2;
+        *text = realloc(*text, *size);
+    }
+    (*text)[(*len)++] = c;
+}
+
+
+// Return true if some special token longer than LEN begins with the LEN
+// characters of OP followed by C
+static int extendsSpecial (char *op, int len, int c)
+{
+    for(int i = 0; i < nSTok; i++)
+    {
+        if(STok[i].length > len && STok[i].text[len] == c &&
+           !strncmp(STok[i].text, op, len))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+// Lex the next command line from FP without building the line.  The
+// character being examined is kept in c; each branch leaves c holding the
+// first character it did not consume.
+token* tokenizeStream (FILE* fp, bool* atEOF)
+{
+    token head,  // Dummy head for token list
+          *tail; // Pointer to last node in token list
+    int c;
+
+    head.next = NULL;
+    tail = &head;
+
+    c = inputGetc(fp);
+    *atEOF = (c == EOF);
+
+    while(c != EOF && c != '\n')
+    {
+        if(isspace(c) || c == '\0') // ignore whitespace (and NUL) characters
+        {
+            c = inputGetc(fp);
+            continue;
+        }
+        else if(c == '#') // ignore comments
+        {
+            while((c = inputGetc(fp)) != EOF && c != '\n');
+            break;
+        }
+        else if(strchr(METACHAR, c)) // special token?
+        {
+            // extend the token while it's a prefix of a longer one; every
+            // prefix of a special token is itself a special token
+            char op[5];
+            int len = 0;
+            op[len++] = c;
+            while((c = inputGetc(fp)) != EOF && len < 4 &&
+                  extendsSpecial(op, len, c))
+            {
+                op[len++] = c;
+            }
+            op[len] = '\0';
+
+            int i;
+            for(i = 0; strcmp(STok[i].text, op); i++);
+
+            tail->next = malloc(sizeof(token));
+            tail = tail->next;
+            tail->next = NULL;
+            tail->type = STok[i].type;
+            tail->text = strdup(STok[i].text);
+            continue;
+        }
+
+        // SIMPLE token
+        {
+            int inQuote = 0; // In quoted string?  Value = type
+            int quoted = 0;  // Saw a quote?  (so the token may be empty)
+            int unmatched = 0; // Line ended inside backquotes?
+            int size = STREAM_TEXT_SIZE, len = 0;
+            char *text = malloc(size);
+
+            for( ; c != EOF; c = inputGetc(fp))
+            {
+                if(c == '`' && inQuote != '\'')   // command substitution?
+                {
+                    int mark = inQuote ? SUBST_QUOTED : SUBST_WORDS;
+                    appendText(&text, &len, &size, mark);
+                    while((c = inputGetc(fp)) != EOF && c != '`' && c != '\n')
+                    {
+                        appendText(&text, &len, &size, c); // Copy verbatim
+                    }
+                    if(c != '`')
+                    {
+                        unmatched = 1;
+                        break;
+                    }
+                    appendText(&text, &len, &size, mark);
+                    quoted = 1;
+                }
+                else if(c == inQuote)             // Matching quote?
+                {
+                    inQuote = 0;                  //     Suppress close quote
+                }
+                else if(inQuote)                  // within quotes?
+                {
+                    if(c == '\n')                 //     Line ended inside
+                    {
+                        break;
+                    }
+                    appendText(&text, &len, &size, c); // Copy character
+                }
+                else if(strchr("'\"", c))         // start quoted string?
+                {
+                    inQuote = c;                  //     Suppress start quote
+                    quoted = 1;
+                }
+                else if(c == '\\')                // escaped char?
+                {
+                    int next = inputGetc(fp);
+                    if(next == EOF)
+                    {
+                        appendText(&text, &len, &size, c); // Keep backslash
+                        break;
+                    }
+                    else if(next != '\n')         // \-newline continues
+                    {
+                        appendText(&text, &len, &size, next); // Drop backslash
+                    }
+                }
+                else if(c && !strchr(METACHAR, c) && // ordinary char?
+                        !isspace(c))
+                {
+                    if(strchr(GLOB_CHARS, c) &&   //     Mark unquoted glob char
+                       !(c == '?' && len > 0 && text[len - 1] == '$')) // but $?
+                    {
+                        appendText(&text, &len, &size, GLOB_MARK);
+                    }
+                    appendText(&text, &len, &size, c); // Copy character
+                }
+                else
+                {
+                    break;
+                }
+            }
+            text[len] = '\0';
+
+            if(unmatched)
+            {
+                parseError("Unmatched `\n");
+                free(text);
+                freeList(head.next);
+                return NULL;
+            }
+            else if(inQuote)
+            {
+                parseError("Unterminated string\n");
+                free(text);
+                freeList(head.next);
+                return NULL;
+            }
+            else if(len == 0 && !quoted) // only continuations
+            {
+                free(text);
+                continue;
+            }
+
+            tail->next = malloc(sizeof(token));
+            tail = tail->next;
+            tail->next = NULL;
+            tail->type = SIMPLE;
+            tail->text = realloc(text, len + 1);
+        }
+    }
+
+    return head.next; // Return token list
+}
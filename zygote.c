@@ -0,0 +1,255 @@
+/*
+ * File:   zygote.c
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Implementation of the zygote described in zygote.h. The shell and zygote
+ * talk over a socketpair. A request is a spawnHeader, sent with the command's
+ * standard input, output, and error attached as SCM_RIGHTS, followed by the
+ * shell's working directory, the command's arguments, and the shell's
+ * environment, all as null-terminated strings. The reply is the pid of the
+ * command's process, or -1.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/prctl.h>
+#include <linux/limits.h>
+#include "zygote.h"
+#include "fullIO.h"
+
+#define MEM_SUBSYSTEM MEM_PROCESS
+#include "memStats.h"
+
+#define SPAWN_FDS (3)
+
+typedef struct {
+    unsigned int argc; // number of arguments
+    unsigned int envc; // number of environment strings
+    unsigned int len;  // length of the strings that follow
+} spawnHeader;
+
+extern char** environ;
+
+static int zygoteFd = -1; // the shell's end of the socketpair
+static pid_t shellPid;    // the shell that started the zygote
+
+// Stores in vec the n null-terminated strings starting at s, followed by NULL.
+// Returns the char following the last string.
+static char* splitStrings(char* s, char** vec, unsigned int n)
+{
+    for(unsigned int i = 0; i < n; i++)
+    {
+        vec[i] = s;
+        s += strlen(s) + 1;
+    }
+    vec[n] = NULL;
+    return s;
+}
+
+// Launches the command in body, described by hdr, with the descriptors in
+// fds. Returns its pid, or -1.
+static pid_t spawn(const spawnHeader* hdr, char* body, const int* fds)
+{
+    static char cwd[PATH_MAX]; // the zygote's working directory
+    char* argv[hdr->argc + 1];
+    char* envp[hdr->envc + 1];
+
+    char* dir = body;
+    char* next = splitStrings(dir + strlen(dir) + 1, argv, hdr->argc);
+    splitStrings(next, envp, hdr->envc);
+
+    // follow the shell's cd's, pushd's, and popd's
+    if(strcmp(dir, cwd) != 0 && chdir(dir) == 0)
+    {
+        snprintf(cwd, sizeof(cwd), "%s", dir);
+    }
+
+    // a fork as far as this process is concerned, but the child's parent is
+    // the shell
+    pid_t pid = syscall(SYS_clone, CLONE_PARENT | SIGCHLD, NULL, NULL, NULL,
+                        NULL);
+    if(pid == 0)
+    {
+        for(int i = 0; i < SPAWN_FDS; i++)
+        {
+            dup2(fds[i], i);
+        }
+        signal(SIGINT, SIG_DFL);
+        signal(SIGPIPE, SIG_DFL);
+
+        environ = envp; // so that execvp() searches the shell's PATH
+        execvp(argv[0], argv);
+        perror("eggshell");
+        _exit(EXIT_FAILURE);
+    }
+    return (pid < 0) ? -1 : pid;
+}
+
+// Serves the shell's requests on fd until it closes its end
+static void zygoteLoop(int fd)
+{
+    for( ; ; )
+    {
+        char control[CMSG_SPACE(sizeof(int) * SPAWN_FDS)];
+        spawnHeader hdr;
+        struct iovec iov = { &hdr, sizeof(hdr) };
+        struct msghdr msg;
+        ssize_t n;
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        while((n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR);
+        if(n <= 0 || !readAll(fd, (char*)&hdr + n, sizeof(hdr) - n))
+        {
+            _exit(EXIT_SUCCESS); // the shell is gone
+        }
+
+        int fds[SPAWN_FDS];
+        int nFds = 0;
+        struct cmsghdr* c = CMSG_FIRSTHDR(&msg);
+        if(c && c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS)
+        {
+            nFds = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            memcpy(fds, CMSG_DATA(c), sizeof(int) * nFds);
+        }
+
+        char* body = malloc(hdr.len);
+        pid_t pid = -1;
+        if(!readAll(fd, body, hdr.len))
+        {
+            _exit(EXIT_SUCCESS);
+        }
+        if(nFds == SPAWN_FDS)
+        {
+            pid = spawn(&hdr, body, fds);
+        }
+        free(body);
+
+        for(int i = 0; i < nFds; i++)
+        {
+            close(fds[i]);
+        }
+        if(!sendAll(fd, &pid, sizeof(pid)))
+        {
+            _exit(EXIT_SUCCESS);
+        }
+    }
+}
+
+int startZygote(void)
+{
+    int sv[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0)
+    {
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if(pid < 0)
+    {
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+    else if(pid == 0)
+    {
+        // zygote; interrupts are for the commands it launches
+        close(sv[0]);
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        signal(SIGINT, SIG_IGN);
+        zygoteLoop(sv[1]);
+    }
+
+    close(sv[1]);
+    zygoteFd = sv[0];
+    shellPid = getpid();
+    return 0;
+}
+
+bool zygoteRunning(void)
+{
+    // a subshell forks for itself, since the zygote's launches are children
+    // of the shell that started it
+    return zygoteFd >= 0 && getpid() == shellPid;
+}
+
+pid_t zygoteSpawn(char** argv, const int* fds)
+{
+    static char cwd[PATH_MAX];
+    if(!zygoteRunning() || !getcwd(cwd, sizeof(cwd)))
+    {
+        return -1;
+    }
+
+    spawnHeader hdr = { 0, 0, strlen(cwd) + 1 };
+    for(char** arg = argv; *arg; arg++, hdr.argc++)
+    {
+        hdr.len += strlen(*arg) + 1;
+    }
+    for(char** var = environ; *var; var++, hdr.envc++)
+    {
+        hdr.len += strlen(*var) + 1;
+    }
+
+    // gather the strings so they take one write()
+    char* body = malloc(hdr.len);
+    char* end = stpcpy(body, cwd) + 1;
+    for(char** arg = argv; *arg; arg++)
+    {
+        end = stpcpy(end, *arg) + 1;
+    }
+    for(char** var = environ; *var; var++)
+    {
+        end = stpcpy(end, *var) + 1;
+    }
+
+    char control[CMSG_SPACE(sizeof(int) * SPAWN_FDS)];
+    struct iovec iov = { &hdr, sizeof(hdr) };
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(msg));
+    memset(control, 0, sizeof(control));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr* c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(sizeof(int) * SPAWN_FDS);
+    memcpy(CMSG_DATA(c), fds, sizeof(int) * SPAWN_FDS);
+
+    pid_t pid;
+    ssize_t n;
+    while((n = sendmsg(zygoteFd, &msg, MSG_NOSIGNAL)) < 0 &&
+          errno == EINTR);
+    bool ok = n >= 0 &&
+              sendAll(zygoteFd, (char*)&hdr + n, sizeof(hdr) - n) &&
+              sendAll(zygoteFd, body, hdr.len) &&
+              readAll(zygoteFd, &pid, sizeof(pid));
+    free(body);
+
+    if(!ok) // the zygote is gone; fork from now on
+    {
+        close(zygoteFd);
+        zygoteFd = -1;
+        return -1;
+    }
+    return pid;
+}
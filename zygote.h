@@ -0,0 +1,38 @@
+/*
+ * File:   zygote.h
+ * Author: agent (agent@local)
+ *
+ * Created on 18 October 2026
+ *
+ * Interface for the zygote, a small helper process forked when the shell
+ * starts, before its heap grows, that launches commands on the shell's
+ * behalf. Forking copies the page tables of the process that forks, so a
+ * shell holding large here documents or scripts launches commands more slowly
+ * than one that doesn't; the zygote's launches cost the same no matter how
+ * much memory the shell uses.
+ *
+ * The zygote creates each command's process with CLONE_PARENT, making it a
+ * child of the shell rather than of the zygote, so the shell waits for it with
+ * waitpid() as though it had forked it itself.
+ */
+
+#ifndef ZYGOTE_H
+#define ZYGOTE_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+// Forks the zygote. Returns 0 if successful, -1 otherwise.
+int startZygote(void);
+
+// Returns true if the zygote is running and launches children of this process
+bool zygoteRunning(void);
+
+// Has the zygote launch argv, searching PATH, in the shell's working
+// directory and environment, with fds[0], fds[1], and fds[2] as its standard
+// input, output, and error. Returns the pid of the command's process, a child
+// of the shell, or -1 if it couldn't be created. Failure to exec is reported
+// by the process itself, as when the shell forks.
+pid_t zygoteSpawn(char** argv, const int* fds);
+
+#endif